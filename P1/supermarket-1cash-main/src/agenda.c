@@ -1,11 +1,15 @@
 /*
  * Programa exemple del funcionament d'una simulacio orientada en events
  * basada en el codi donat en el llibre Jorba, Capitol 2
- * 
+ *
  * LLibreria de funcions de l'agenda d'events
- * 
+ *
+ * L'agenda es un monticle binari (heap) de minims ordenat per "quan" que
+ * creix sota demanda. Els events amb el mateix "quan" surten en l'ordre en
+ * que s'han posat (FIFO). Posar i treure un event costa O(log n).
+ *
  * File:   agenda.c
- * 
+ *
  * Author: Dolors Sala
  */
 
@@ -14,23 +18,54 @@
 
 #define DEBUGagenda 1   // Bandera per fer seguiment de l'agenda 
 
-//static esdev *agenda;
-static int n_esd;
-static int ara ;  // ultim component plena de l'agenda ordenada de major a menor del 0 a ara
+// Node del monticle: l'event i el seu ordre d'insercio per desempatar
+typedef struct {
+    esdev e;
+    unsigned long ordre;
+}nesdev;
+
+static nesdev *agenda;        // Monticle d'events: agenda[0] es el proxim event
+static int n_esd;             // Capacitat actual de l'agenda
+static int ara ;              // ultima component plena del monticle (-1 agenda buida)
+static unsigned long n_ordre; // Comptador d'insercions per mantenir l'ordre FIFO
+
+// Cert si el node a s'ha d'executar abans que el node b
+static int abans(nesdev *a, nesdev *b){
+    if (a->e.quan != b->e.quan)
+        return (a->e.quan < b->e.quan);
+    return (a->ordre < b->ordre);
+}
 
 // Inicialitza l'agenda amb n posicions per tenir n events esperant a ser executats
+// Si cal mes espai l'agenda es fa creixer automaticament
 void ini_agenda(int n){
-    n_esd = n;
-    agenda = (esdev*) malloc(n_esd * sizeof (esdev));
+    n_esd = (n > 0) ? n : 1;
+    agenda = (nesdev*) malloc(n_esd * sizeof (nesdev));
     if (agenda == NULL){
         puts("Agenda: falta memoria");
         exit (-1);
     }
     ara = -1;
+    n_ordre = 0;
+}
+
+// Dobla la capacitat de l'agenda
+static void creix_agenda(void){
+    nesdev *nova;
+
+    nova = (nesdev*) realloc(agenda, 2 * n_esd * sizeof (nesdev));
+    if (nova == NULL){
+        puts("Agenda: falta memoria");
+        exit (-1);
+    }
+    agenda = nova;
+    n_esd = 2 * n_esd;
 }
+
 void imprimir_element_agenda(int i){
-    printf("(%c, %8.4lf)",agenda[i].que,agenda[i].quan);
+    printf("(%c, %8.4lf)",agenda[i].e.que,agenda[i].e.quan);
 }
+// Imprimeix l'agenda en l'ordre del monticle (el primer es el proxim event)
 void imprimir_agenda(){
     int i;
     printf("Agenda (%2d): ",ara);
@@ -50,21 +85,25 @@ esdev crea_esdev(int que, float quan){
 // Afegeix l'event e a l'agenda ordenat cronologicament segons el "quan"
 // El ta és el temps actual per imprimir en les traces de seguiment
 void posa_agenda(float ta, esdev e) {
-    int i;
-    
+    int i, pare;
+    nesdev n;
+
     ++ara;
-    if (ara == N){
-        puts("Error, agenda plena");
-        exit(1);
-    }
-    for (i = ara; i > 0; i--){
-        if(e.quan <= agenda[i-1].quan)
-                break;
-        agenda[i] = agenda[i-1];
+    if (ara == n_esd)
+        creix_agenda();
+    n.e = e;
+    n.ordre = n_ordre++;
+
+    // puja el nou node fins que el pare s'executi abans
+    for (i = ara; i > 0; i = pare){
+        pare = (i - 1) / 2;
+        if (!abans(&n, &agenda[pare]))
+            break;
+        agenda[i] = agenda[pare];
     }
-    agenda[i]=e;
-    
-#if DEBUGagenda == 1 
+    agenda[i] = n;
+
+#if DEBUGagenda == 1
    printf("%.4lf Posa AGENDA %2d: ", ta, ara);
    imprimir_agenda();
 #endif
@@ -73,23 +112,37 @@ void posa_agenda(float ta, esdev e) {
 // Elimina l'element e de l'agenda
 // El ta és el temps actual per imprimir en les traces de seguiment
 int treu_agenda(float ta, esdev *e){
+    int i, fill;
+    nesdev darrer;
 
-#if DEBUGagenda == 1 
+#if DEBUGagenda == 1
     printf("%.4lf Treu AGENDA %2d ", ta, ara);
-    imprimir_element_agenda(ara);
+    if(ara != -1) imprimir_element_agenda(0);
     //printf(": ");
 #endif
     if(ara == -1) {// agenda buida
-        return(0); 
+        return(0);
     }
-    *e = agenda[ara];
+    *e = agenda[0].e;
+    darrer = agenda[ara];
     --ara;
-    
-#if DEBUGagenda == 1 
+
+    // baixa el darrer node des de l'arrel fins al seu lloc
+    for (i = 0; (fill = 2 * i + 1) <= ara; i = fill){
+        if (fill < ara && abans(&agenda[fill + 1], &agenda[fill]))
+            fill++;
+        if (!abans(&agenda[fill], &darrer))
+            break;
+        agenda[i] = agenda[fill];
+    }
+    if (ara >= 0)
+        agenda[i] = darrer;
+
+#if DEBUGagenda == 1
     //printf("%.4lf Treu AGENDA %2d: ", ta, ara);
     imprimir_agenda();
 #endif
-    
+
     return(1);
 }//treu_agenda
 
@@ -99,5 +152,7 @@ void buida_agenda(void){
 
 void allibera_agenda(void){
     free(agenda);
+    agenda = NULL;
+    n_esd = 0;
 }
 
@@ -12,7 +12,7 @@
 #define	AGENDA_H
 
 // Declaracion per l'agenda d'events
-#define N           10   // Nombre maxim d'events pendents d'executar
+#define N           10   // Capacitat inicial de l'agenda d'events (creix sota demanda)
 
 typedef struct {
     float quan;
@@ -26,6 +26,5 @@ int treu_agenda(float ta, esdev *e);
 void buida_agenda(void);
 void allibera_agenda(void);
 
-static esdev *agenda; // Llista d'events ordenats cronologicament
 #endif	/* AGENDA_H */
 
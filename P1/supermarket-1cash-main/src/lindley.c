@@ -0,0 +1,288 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Motor alternatiu per al cas d'1 caixer FIFO: en lloc de passar cada
+ * client per l'agenda i la cua, el temps de cua es calcula amb la
+ * recursio de Lindley
+ *
+ *     W(n+1) = max(0, W(n) + S(n) - A(n+1))
+ *
+ * Amb V(n) = W(n) + S(n) (temps des de l'arribada fins la sortida), cada
+ * client es la funcio max-plus v -> max(S(n), v + S(n) - A(n)), i la
+ * composicio de funcions max(a, v + b) torna a ser de la mateixa forma:
+ *
+ *     (a2,b2) o (a1,b1) = (max(a2, a1 + b2), b1 + b2)
+ *
+ * Aixo permet fer la recursio com una suma prefix (scan) en paral·lel.
+ * Cada ronda, cada fil genera LINDBLOC clients repartits en LINDCARRILS
+ * carrils de LINDPAS clients consecutius, guardats intercalats
+ * (client i del carril j a la posicio i*LINDCARRILS + j) perque el bucle
+ * interior sobre els carrils es pugui vectoritzar:
+ *   1) cada carril es resumeix en (a, b) i la suma dels temps entre arribades
+ *   2) barrera; cada fil combina en ordre els resums de tots els carrils per
+ *      saber amb quin estat (v, rellotge) comença cadascun dels seus
+ *   3) es refa la recursio de cada carril des del seu estat real i s'acumulen
+ *      les estadistiques dels clients arribats abans de tancar
+ * Els valors aleatoris de cada client nomes depenen de la llavor i del
+ * numero de client (alea_bloc), de manera que el resultat no depen del
+ * nombre de fils (llevat de l'arrodoniment de les sumes).
+ *
+ * El motor d'events continua essent la referencia per validar aquest.
+ *
+ * File:   lindley.c
+ * Author: Dolors Sala
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "sev.h"
+#include "lindley.h"
+
+#define FLUXARRIBADA 0   // flux aleatori dels temps entre arribades
+#define FLUXSERVEI   1   // flux aleatori dels temps de servei
+
+#define MAXD(a, b)  ((a) > (b) ? (a) : (b))
+
+// Resum d'un carril: funcio v -> max(a, v + b) i temps entre arribades
+typedef struct {
+    double a;
+    double b;
+    double sa;
+} sresum;
+
+// Barrera reutilitzable (pthread_barrier_t no existeix a tots els sistemes)
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int n;                // fils que s'han d'esperar
+    int esperant;
+    unsigned long torn;
+} sbarrera;
+
+// Estat compartit pels fils del motor
+typedef struct {
+    int nfils;
+    double tancar;               // les arribades posteriors no s'atenen
+    unsigned long long clau_arr; // claus dels fluxos aleatoris
+    unsigned long long clau_ser;
+    sresum *resum[2];            // resums de la ronda (parell i senar) [nfils*LINDCARRILS]
+    slindley *parcial;           // resultats de cada fil
+    sbarrera barrera;
+} smotor;
+
+// Parametres de cada fil
+typedef struct {
+    smotor *m;
+    int f;
+    pthread_t fil;
+} sfil;
+
+static void ini_barrera(sbarrera *b, int n){
+    pthread_mutex_init(&b->mutex, NULL);
+    pthread_cond_init(&b->cond, NULL);
+    b->n = n;
+    b->esperant = 0;
+    b->torn = 0;
+} // ini_barrera
+
+static void espera_barrera(sbarrera *b){
+    unsigned long torn;
+
+    pthread_mutex_lock(&b->mutex);
+    torn = b->torn;
+    if(++b->esperant == b->n){
+        b->esperant = 0;
+        b->torn++;
+        pthread_cond_broadcast(&b->cond);
+    }else{
+        while(torn == b->torn)
+            pthread_cond_wait(&b->cond, &b->mutex);
+    }
+    pthread_mutex_unlock(&b->mutex);
+} // espera_barrera
+
+static void elim_barrera(sbarrera *b){
+    pthread_mutex_destroy(&b->mutex);
+    pthread_cond_destroy(&b->cond);
+} // elim_barrera
+
+// Genera els temps entre arribades (ta) i de servei (ts) dels clients
+// n0..n0+LINDBLOC-1 en l'ordre intercalat per carrils. u es un espai de
+// LINDPAS valors per als uniformes d'un carril.
+static void genera_bloc(smotor *m, unsigned long long n0, double *ta, double *ts, double *u){
+    int i, j;
+
+    for(j = 0; j < LINDCARRILS; j++){
+        alea_bloc(m->clau_arr, n0 + (unsigned long long) j * LINDPAS, LINDPAS, u);
+        for(i = 0; i < LINDPAS; i++)
+            ta[i * LINDCARRILS + j] = -ARRIVAL * log(u[i]);
+        alea_bloc(m->clau_ser, n0 + (unsigned long long) j * LINDPAS, LINDPAS, u);
+        for(i = 0; i < LINDPAS; i++)
+            ts[i * LINDCARRILS + j] = 1 - SERVICE * log(u[i]);
+    }
+} // genera_bloc
+
+// Resumeix cada carril del bloc: a es v al final del carril si entra buit,
+// b la suma de S - A i sa la suma dels temps entre arribades
+static void resumeix_bloc(const double *ta, const double *ts, sresum *r){
+    double a[LINDCARRILS], b[LINDCARRILS], sa[LINDCARRILS];
+    double w;
+    int i, j;
+
+    for(j = 0; j < LINDCARRILS; j++)
+        a[j] = b[j] = sa[j] = 0.0;
+    for(i = 0; i < LINDPAS; i++){
+        for(j = 0; j < LINDCARRILS; j++){
+            w = a[j] - ta[i * LINDCARRILS + j];
+            a[j] = MAXD(w, 0.0) + ts[i * LINDCARRILS + j];
+            b[j] += ts[i * LINDCARRILS + j] - ta[i * LINDCARRILS + j];
+            sa[j] += ta[i * LINDCARRILS + j];
+        }
+    }
+    for(j = 0; j < LINDCARRILS; j++){
+        r[j].a = a[j];
+        r[j].b = b[j];
+        r[j].sa = sa[j];
+    }
+} // resumeix_bloc
+
+// Refa la recursio de cada carril des del seu estat d'entrada (v, t) i
+// acumula el temps de cua dels clients arribats abans de tancar
+static void acumula_bloc(const double *ta, const double *ts, const double *v0, const double *t0,
+                         double tancar, slindley *r){
+    double v[LINDCARRILS], t[LINDCARRILS];
+    double n[LINDCARRILS], sw[LINDCARRILS], mw[LINDCARRILS];
+    double w, d, dins;
+    int i, j;
+
+    for(j = 0; j < LINDCARRILS; j++){
+        v[j] = v0[j];
+        t[j] = t0[j];
+        n[j] = sw[j] = mw[j] = 0.0;
+    }
+    for(i = 0; i < LINDPAS; i++){
+        for(j = 0; j < LINDCARRILS; j++){
+            t[j] += ta[i * LINDCARRILS + j];
+            w = v[j] - ta[i * LINDCARRILS + j];
+            w = MAXD(w, 0.0);
+            v[j] = w + ts[i * LINDCARRILS + j];
+            dins = (t[j] <= tancar);           // fora d'hora no compta
+            d = dins * w;
+            n[j] += dins;
+            sw[j] += d;
+            mw[j] = MAXD(mw[j], d);
+        }
+    }
+    for(j = 0; j < LINDCARRILS; j++){
+        r->nca += (long long) n[j];
+        r->tsum += sw[j];
+        r->tmax = MAXD(r->tmax, mw[j]);
+    }
+} // acumula_bloc
+
+// Fil de treball f: a la ronda k fa els LINDBLOC clients a partir del
+// (k*nfils + f)*LINDBLOC, fins que la ronda comença despres de tancar
+static void *treballador(void *arg){
+    sfil *p = (sfil *) arg;
+    smotor *m = p->m;
+    slindley *r = &m->parcial[p->f];
+    double *ta, *ts, *u;
+    double v0[LINDCARRILS], t0[LINDCARRILS];
+    double v = 0.0, t = 0.0;   // estat a l'entrada de la ronda (igual a tots els fils)
+    sresum *rs;
+    unsigned long long k;
+    int c, ini, fi, nc;
+
+    ta = (double *) malloc(LINDBLOC * sizeof(double));
+    ts = (double *) malloc(LINDBLOC * sizeof(double));
+    u = (double *) malloc(LINDPAS * sizeof(double));
+    if(ta == NULL || ts == NULL || u == NULL){
+        puts("Motor Lindley: No hi ha prou memoria pels blocs de clients");
+        exit(-1);
+    }
+    nc = m->nfils * LINDCARRILS;
+    ini = p->f * LINDCARRILS;
+    fi = ini + LINDCARRILS;
+    for(k = 0; t <= m->tancar; k++){
+        genera_bloc(m, (k * m->nfils + p->f) * LINDBLOC, ta, ts, u);
+        rs = m->resum[k % 2];
+        resumeix_bloc(ta, ts, rs + ini);
+        espera_barrera(&m->barrera);   // resums de la ronda complets
+
+        // Tots els fils combinen els resums en el mateix ordre
+        for(c = 0; c < nc; c++){
+            if(c >= ini && c < fi){
+                v0[c - ini] = v;
+                t0[c - ini] = t;
+            }
+            v = MAXD(rs[c].a, v + rs[c].b);
+            t += rs[c].sa;
+        }
+        if(t0[0] <= m->tancar)   // algun carril comença abans de tancar
+            acumula_bloc(ta, ts, v0, t0, m->tancar, r);
+        r->rondes++;
+    }
+    free(ta);
+    free(ts);
+    free(u);
+    return(NULL);
+} // treballador
+
+// Nombre de nuclis disponibles
+static int nombre_nuclis(void){
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0 ? (int) n : 1);
+} // nombre_nuclis
+
+// Simula el supermercat obert fins a tancar amb el motor de Lindley en
+// nfils fils (0 = tants com nuclis) i deixa els resultats a r
+int simula_lindley(double tancar, unsigned long long llavor, int nfils, slindley *r){
+    smotor m;
+    sfil *fils;
+    int f;
+
+    if(nfils <= 0) nfils = nombre_nuclis();
+    m.nfils = nfils;
+    m.tancar = tancar;
+    m.clau_arr = clau_flux(llavor, FLUXARRIBADA);
+    m.clau_ser = clau_flux(llavor, FLUXSERVEI);
+    m.resum[0] = (sresum *) malloc(nfils * LINDCARRILS * sizeof(sresum));
+    m.resum[1] = (sresum *) malloc(nfils * LINDCARRILS * sizeof(sresum));
+    m.parcial = (slindley *) calloc(nfils, sizeof(slindley));
+    fils = (sfil *) malloc(nfils * sizeof(sfil));
+    if(m.resum[0] == NULL || m.resum[1] == NULL || m.parcial == NULL || fils == NULL){
+        puts("Motor Lindley: No hi ha prou memoria");
+        exit(-1);
+    }
+    ini_barrera(&m.barrera, nfils);
+
+    for(f = 0; f < nfils; f++){
+        fils[f].m = &m;
+        fils[f].f = f;
+        if(pthread_create(&fils[f].fil, NULL, treballador, &fils[f]) != 0){
+            printf("ERROR: no es pot crear el fil %d del motor Lindley\n", f);
+            exit(-1);
+        }
+    }
+    for(f = 0; f < nfils; f++)
+        pthread_join(fils[f].fil, NULL);
+
+    r->nca = 0;
+    r->tmax = r->tsum = 0.0;
+    r->rondes = m.parcial[0].rondes;
+    r->nfils = nfils;
+    for(f = 0; f < nfils; f++){
+        r->nca += m.parcial[f].nca;
+        r->tsum += m.parcial[f].tsum;
+        r->tmax = MAXD(r->tmax, m.parcial[f].tmax);
+    }
+
+    elim_barrera(&m.barrera);
+    free(m.resum[0]);
+    free(m.resum[1]);
+    free(m.parcial);
+    free(fils);
+    return(0);
+} // simula_lindley
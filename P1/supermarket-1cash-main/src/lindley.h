@@ -0,0 +1,29 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Declaracions del motor de recursio de Lindley (alternatiu a l'agenda)
+ *
+ * File:   lindley.h
+ * Author: Dolors Sala
+ */
+
+#ifndef LINDLEY_H
+#define	LINDLEY_H
+
+#define LINDCARRILS 16     // carrils que es recorren alhora (multiple de l'amplada SIMD)
+#define LINDPAS     1024   // clients consecutius de cada carril per ronda
+#define LINDBLOC    (LINDCARRILS * LINDPAS)  // clients de cada fil per ronda
+
+// Resultats del motor de Lindley
+typedef struct {
+    long long nca;     // nombre de clients atesos (arribats abans de tancar)
+    double tmax;       // temps maxim de cua
+    double tsum;       // suma dels temps de cua
+    long long rondes;  // rondes de LINDBLOC clients per fil
+    int nfils;
+} slindley;
+
+int simula_lindley(double tancar, unsigned long long llavor, int nfils, slindley *r);
+
+#endif	/* LINDLEY_H */
@@ -15,12 +15,61 @@
 #include "./sev.h"
 #include "./cua.h"
 #include "./agenda.h"
+#include "./lindley.h"
 #include <time.h>
+#include <unistd.h>
 
 
 #define DEBUGserv 1  // Bandera per fer seguiment del servei
 
-int main(void) {
+static int motor_lindley = 0;   // 1: recursio de Lindley en lloc de l'agenda
+
+// Llegeix les opcions de la linia de comandes:
+//   -l        motor de recursio de Lindley (el motor d'events es la referencia)
+//   -t temps  temps de tancament (TANCARTIME per defecte)
+//   -s llavor llavor del generador (RANSEED per defecte, 0 aleatoria)
+//   -j fils   fils del motor de Lindley (per defecte, tots els nuclis)
+static void input_parameters(int argc, char **argv, float *tancar, long int *llavor, int *nfils){
+    int opt;
+
+    while((opt = getopt(argc, argv, "lt:s:j:")) != -1){
+        switch(opt){
+            case 'l': motor_lindley = 1; break;
+            case 't': *tancar = atof(optarg); break;
+            case 's': *llavor = atol(optarg); break;
+            case 'j': *nfils  = atoi(optarg); break;
+            default:
+                fprintf(stderr, "Use: %s [-l] [-t tancar] [-s llavor] [-j fils]\n", argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if(*tancar <= OBRIRTIME){
+        fprintf(stderr, "ERROR: el temps de tancament ha de ser posterior a l'obertura\n");
+        exit(EXIT_FAILURE);
+    }
+} // input_parameters
+
+// Executa el motor de Lindley i escriu els mateixos resultats que el d'events
+static int executa_lindley(float tancar, long int llavor, int nfils){
+    slindley r;
+    struct timespec t0, t1;
+    double seg;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    simula_lindley(tancar - OBRIRTIME, (unsigned long long) llavor, nfils, &r);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    seg = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+    printf("\n\n-------------------------\n");
+    printf("Motor Lindley: %d fils, %lld rondes de %d clients per fil\n", r.nfils, r.rondes, LINDBLOC);
+    printf("Nombre de clients atesos: %lld\n", r.nca);
+    printf("Temps maxim de cua: %f\n", r.tmax);
+    printf("Temps promig de cua: %f\n", r.nca > 0 ? r.tsum / r.nca : 0.0);
+    printf("Temps d'execucio: %.3lf s (%.3g clients/s)\n", seg, seg > 0 ? r.nca / seg : 0.0);
+    return (1);
+} // executa_lindley
+
+int main(int argc, char **argv) {
     esdev e;
     el_cua c;
     float t;
@@ -30,12 +79,18 @@ int main(void) {
     float tmax; // temps maxim en el sistema
     int nca;    // nombre de clients atesos
     int j;
+    float tancar = TANCARTIME; // temps de tancament
+    int nfils = 0;  // fils del motor de Lindley (0 = nombre de nuclis)
     //Inicialitzar generador numeros aleatoris
     long int llavor = RANSEED;
+
+    input_parameters(argc, argv, &tancar, &llavor, &nfils);
     if(llavor == 0){  // Zero for random start 
         llavor = time(0); 
         printf("\nRandom seed, seed chosen: %ld\n",llavor);
     }
+    if(motor_lindley)
+        return (executa_lindley(tancar, llavor, nfils));
     srand(llavor);    
 
     
@@ -45,7 +100,7 @@ int main(void) {
     e = crea_esdev(OBRIR, OBRIRTIME);
     posa_agenda(ta, e);
     
-    e = crea_esdev(TANCAR, TANCARTIME);
+    e = crea_esdev(TANCAR, tancar);
     posa_agenda(ta, e);
     
     bn = 0;
@@ -28,6 +28,8 @@
 #define TANCARTIME 100 //200     // Temps de finalització
 
 float expo(float m);
+unsigned long long clau_flux(unsigned long long llavor, int flux);
+void alea_bloc(unsigned long long clau, unsigned long long n0, int m, double *u);
    
 #endif
 
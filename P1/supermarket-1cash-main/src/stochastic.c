@@ -31,3 +31,24 @@ float expo(float m){
 }
 
 
+// 64-bit mixing function of splitmix64
+static unsigned long long barreja(unsigned long long z){
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return(z ^ (z >> 31));
+} // barreja
+
+// Key of the counter-based stream flux for the given seed (see alea_bloc)
+unsigned long long clau_flux(unsigned long long llavor, int flux){
+    return(barreja(llavor + 0x9e3779b97f4a7c15ULL * (unsigned long long)(flux + 1)));
+} // clau_flux
+
+// Fills u[0..m-1] with the values n0..n0+m-1 (uniform in (0..1)) of the
+// stream with key clau. Value n only depends on the key and on n, so any
+// block of the stream can be generated by any thread without shared state.
+void alea_bloc(unsigned long long clau, unsigned long long n0, int m, double *u){
+    int i;
+
+    for(i = 0; i < m; i++)
+        u[i] = ((barreja(clau + 0x9e3779b97f4a7c15ULL * (n0 + i)) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+} // alea_bloc
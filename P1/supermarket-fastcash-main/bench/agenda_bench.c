@@ -0,0 +1,171 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Benchmark de l'agenda d'events amb el model "hold" clàssic (sense traces):
+ * es mantenen n events pendents i es repeteix treure el primer i tornar-lo
+ * a posar amb un increment de temps aleatori. Es fa per n = 10 ... nmax
+ * i s'escriu una línia CSV per cada n (dist,n,ops,ns_op,peak_rss_kb).
+ * Abans es comprova que cancel·lar i reprogramar events per identificador
+ * funciona.
+ *
+ * Use: agenda-bench [E|B] [nmax] [ops]
+ *      E = increments exponencials de mitjana 1 (per defecte)
+ *      B = increments bimodals de mitjana 1 (90% U[0,0.1), 10% U[9.1,10))
+ * Example: agenda-bench B 1000000 1000000 > bench.csv
+ *
+ * File:   agenda_bench.c
+ * Author: Dolors Sala
+ */
+
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "sev.h"
+#include "agenda.h"
+
+#define BENCHNMAX   1000000 // n maxim d'events pendents per defecte
+#define BENCHOPS    1000000 // operacions hold mesurades per cada n
+
+FILE *ofile = NULL;         // Fitxer de sortida que fa servir imprimir_agenda
+
+// Genera ops increments de temps de mitjana 1 segons la distribucio dist
+static float *genera_increments(char dist, long ops){
+    long i;
+    double u;
+    float *inc = (float *) malloc(ops * sizeof(float));
+
+    if(inc == NULL){
+        fprintf(stderr, "ERROR agenda-bench: no hi ha memoria pels increments\n");
+        exit(EXIT_FAILURE);
+    }
+    for(i = 0; i < ops; i++){
+        if(dist == 'B'){
+            u = drand();
+            if(drand() < 0.9)
+                inc[i] = 0.1 * u;
+            else
+                inc[i] = 9.1 + 0.9 * u;
+        }
+        else
+            inc[i] = expo(1.0);
+    }
+    return(inc);
+} // genera_increments
+
+// Temps actual en nanosegons
+static double ara_ns(void){
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return(ts.tv_sec * 1e9 + ts.tv_nsec);
+} // ara_ns
+
+// Pic de memoria resident del proces en KB
+static long pic_memoria_kb(void){
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+#ifdef __APPLE__
+    return(ru.ru_maxrss / 1024); // macOS el dona en bytes
+#else
+    return(ru.ru_maxrss);
+#endif
+} // pic_memoria_kb
+
+// Comprova els identificadors d'events abans de mesurar: cancel·lar,
+// reprogramar i rebutjar els identificadors d'events que ja no hi son
+// (tambe quan el seu slot s'ha tornat a fer servir). Surt si falla.
+static void comprova_identificadors(void){
+    hesdev h[4], nou;
+    esdev e;
+    int i, ok = 1;
+
+    ini_agenda(2);   // petita perque hagi de creixer
+    for(i = 0; i < 4; i++)
+        h[i] = posa_agenda(0, crea_esdev(ARRIBADA, i + 1, i));
+    for(i = 0; i < 4; i++)
+        ok = ok && h[i] >= 0 && pendent_agenda(h[i]);
+    ok = ok && cancela_agenda(0, h[1]) == 1 && !pendent_agenda(h[1]);
+    ok = ok && cancela_agenda(0, h[1]) == 0;                  // ja cancel·lat
+    ok = ok && reprograma_agenda(0, h[0], 10) == 1 && pendent_agenda(h[0]);
+    ok = ok && reprograma_agenda(0, h[1], 10) == 0;           // ja cancel·lat
+    // L'ordre ha de ser 3 (quan 3), 4 (quan 4) i 1 (reprogramat a 10)
+    ok = ok && treu_agenda(0, &e) && e.on == 2 && !pendent_agenda(h[2]);
+    ok = ok && treu_agenda(0, &e) && e.on == 3;
+    // El slot lliure es reutilitza: l'identificador antic no el pot tocar
+    nou = posa_agenda(0, crea_esdev(SORTIDA, 5, 9));
+    ok = ok && nou != h[1] && nou != h[2] && nou != h[3];
+    ok = ok && cancela_agenda(0, h[2]) == 0 && cancela_agenda(0, h[3]) == 0;
+    ok = ok && reprograma_agenda(0, h[3], 1) == 0 && pendent_agenda(nou);
+    ok = ok && treu_agenda(0, &e) && e.on == 9 && e.quan == 5;
+    ok = ok && treu_agenda(0, &e) && e.on == 0 && e.quan == 10;
+    ok = ok && !treu_agenda(0, &e) && !pendent_agenda(h[0]) && !pendent_agenda(nou);
+    ok = ok && cancela_agenda(0, -1) == 0 && !pendent_agenda(NA);
+    allibera_agenda();
+    if(!ok){
+        fprintf(stderr, "ERROR agenda-bench: els identificadors d'events no funcionen\n");
+        exit(EXIT_FAILURE);
+    }
+} // comprova_identificadors
+
+// Omple l'agenda amb n events i fa ops operacions hold.
+// Retorna els nanosegons per operacio hold (treure + posar)
+static double hold(long n, float *inc, long ops){
+    long i, k = 0;
+    esdev e;
+    double t0, t1;
+
+    ini_agenda(N);
+    for(i = 0; i < n; i++){
+        posa_agenda(0, crea_esdev(ARRIBADA, inc[k], NA));
+        k = (k + 1) % ops;
+    }
+    // escalfament: que l'agenda arribi a l'estat estacionari del hold
+    for(i = 0; i < n && i < ops; i++){
+        treu_agenda(0, &e);
+        e.quan += inc[k];
+        posa_agenda(0, e);
+        k = (k + 1) % ops;
+    }
+    t0 = ara_ns();
+    for(i = 0; i < ops; i++){
+        treu_agenda(0, &e);
+        e.quan += inc[k];
+        posa_agenda(0, e);
+        if(++k == ops) k = 0;
+    }
+    t1 = ara_ns();
+    allibera_agenda();
+    return((t1 - t0) / ops);
+} // hold
+
+int main(int argc, char **argv){
+    char dist = 'E';
+    long nmax = BENCHNMAX;
+    long ops  = BENCHOPS;
+    long n;
+    double ns;
+    float *inc;
+
+    ofile = stderr;
+    if(argc > 1) dist = argv[1][0];
+    if(argc > 2) nmax = atol(argv[2]);
+    if(argc > 3) ops  = atol(argv[3]);
+    if((dist != 'E' && dist != 'B') || nmax < 1 || ops < 1){
+        fprintf(stderr, "Use: agenda-bench [E|B] [nmax] [ops]\n");
+        exit(EXIT_FAILURE);
+    }
+    comprova_identificadors();
+    ini_alea(RANSEED, 0);
+    inc = genera_increments(dist, ops);
+
+    printf("dist,n,ops,ns_op,peak_rss_kb\n");
+    for(n = 10; n <= nmax; n *= 10){
+        ns = hold(n, inc, ops);
+        printf("%c,%ld,%ld,%.2lf,%ld\n", dist, n, ops, ns, pic_memoria_kb());
+        fflush(stdout);
+    }
+    free(inc);
+    return(0);
+} // main
@@ -0,0 +1,278 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Benchmark de punta a punta del motor sequencial (sev.c compilat amb
+ * SEV_SENSE_MAIN, sense linia de comandes). Les traces hi son apagades
+ * perque no es crida mai ini_traca (el simulador les activa totes si
+ * SEV_TRACA no diu el contrari). Per cada
+ * punt de la graella (caixers, carrega, dies) simula els dies com a
+ * replicacions seguides i escriu a la sortida un JSON amb:
+ *   - events i events per segon de simula() (sense cap mesura a dins)
+ *   - ns per event de cada tipus, d'una segona passada amb les mateixes
+ *     llavors que cronometra cada tracta_esdev (sense el cost del rellotge)
+ *   - temps de collect_stats de l'ultim dia
+ *   - pic de memoria resident del punt (cada punt s'executa en un fill)
+ *
+ * La carrega u es la de cada caixer: el temps entre arribades es
+ * (1 + SERVICE) / (u * caixers) i els caixers rapids son la mateixa fraccio
+ * dels caixers que la de clients rapids (FRAC_RAPIDS arrodonida), com a
+ * minim un i deixant-ne almenys un de lent: calen 2 caixers o mes, com al
+ * simulador.
+ *
+ * Use: sim-bench [-n caixers,...] [-u carrega,...] [-d dies,...] [-s llavor]
+ * Example: sim-bench -n 2,10,100,1000,10000 -u 0.5,0.9 -d 1,10 > bench.json
+ *
+ * File:   sim_bench.c
+ * Author: Dolors Sala
+ */
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "sev.h"
+#include "agenda.h"
+#include "cua.h"
+#include "stats.h"
+#include "replica.h"
+
+#define BENCHMAXLLISTA  32          // valors maxims de cada eix de la graella
+#define BENCHCAIXERS    "2,10,100,1000,10000"
+#define BENCHCARREGA    "0.5,0.9"
+#define BENCHDIES       "1"
+#define BENCHCALIBRA    100000      // lectures del rellotge per mesurar-ne el cost
+
+// Tipus d'events del model i noms que surten al JSON
+static const char tipus_esdev[] = {OBRIR, ARRIBADA, SORTIDA, TANCAR};
+static const char *nom_esdev[] = {"OBRIR", "ARRIBADA", "SORTIDA", "TANCAR"};
+#define BENCHTIPUS  ((int) sizeof(tipus_esdev))
+
+// Resultats d'un punt de la graella
+typedef struct {
+    long long events;                // events de tots els dies
+    double segons;                   // temps de simula() de tots els dies
+    long long n_tipus[BENCHTIPUS];   // events de cada tipus
+    double ns_tipus[BENCHTIPUS];     // ns de tracta_esdev de cada tipus
+    double stats_ns;                 // collect_stats de l'ultim dia
+} spunt_bench;
+
+// Temps actual en nanosegons
+static double ara_ns(void){
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return(ts.tv_sec * 1e9 + ts.tv_nsec);
+} // ara_ns
+
+// Pic de memoria resident del proces en KB
+static long pic_memoria_kb(void){
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+#ifdef __APPLE__
+    return(ru.ru_maxrss / 1024); // macOS el dona en bytes
+#else
+    return(ru.ru_maxrss);
+#endif
+} // pic_memoria_kb
+
+// Cost de cronometrar un event buit (ns), que es resta de cada event
+static double cost_rellotge(void){
+    double t0, t = 0;
+    int i;
+
+    for(i = 0; i < BENCHCALIBRA; i++){
+        t0 = ara_ns();
+        t += ara_ns() - t0;
+    }
+    return(t / BENCHCALIBRA);
+} // cost_rellotge
+
+// Llegeix la llista de valors separats per comes s a v. Retorna quants n'hi ha
+// (0 si la llista no es valida)
+static int llegeix_llista(const char *s, double *v){
+    char *fi;
+    int n = 0;
+
+    while(n < BENCHMAXLLISTA){
+        v[n] = strtod(s, &fi);
+        if(fi == s || v[n] <= 0)
+            return(0);
+        n++;
+        if(*fi == '\0')
+            return(n);
+        if(*fi != ',')
+            return(0);
+        s = fi + 1;
+    }
+    return(0);
+} // llegeix_llista
+
+// Index de l'event que a tipus_esdev (BENCHTIPUS si no es del model)
+static int index_tipus(int que){
+    int i;
+
+    for(i = 0; i < BENCHTIPUS && tipus_esdev[i] != que; i++)
+        ;
+    return(i);
+} // index_tipus
+
+// Un dia cronometrant cada event, com el bucle de simula() sense punts de
+// control. Deixa les estadistiques a sts.
+static void dia_cronometrat(int ntc, sstats *sts, double rellotge, spunt_bench *r){
+    ssim s;
+    esdev e;
+    double t0, t;
+    int k;
+
+    ini_simulacio(&s, ntc);
+    while(primer_agenda(&e) != 0){
+        treu_agenda(s.ta, &e);
+        k = index_tipus(e.que);
+        t0 = ara_ns();
+        if(tracta_esdev(&s, e, ntc, sts) != 0){
+            fprintf(stderr, "ERROR sim-bench: event desconegut %c\n", e.que);
+            exit(EXIT_FAILURE);
+        }
+        if(k < BENCHTIPUS){
+            t = ara_ns() - t0 - rellotge;
+            r->ns_tipus[k] += (t > 0) ? t : 0;   // el soroll del rellotge no fa temps negatius
+            r->n_tipus[k]++;
+        }
+    }
+    actualitzar_stats_cua(s.cues, ntc, s.ta, sts);
+    tanca_mser(sts);
+    elim_cues(s.cues, ntc);
+    allibera_agenda();
+} // dia_cronometrat
+
+// Executa el punt (ntc caixers, carrega u, dies) i en deixa els resultats a r
+static void executa_punt(int ntc, double u, int dies, long llavor, spunt_bench *r){
+    sstats sts;
+    double t0;
+    int d, k;
+
+    n_rapids = (int) (FRAC_RAPIDS * ntc + 0.5);
+    if(n_rapids < 1)
+        n_rapids = 1;
+    if(n_rapids > ntc - 1)
+        n_rapids = ntc - 1;
+    fraccio_rapids = (double) n_rapids / ntc;
+    temps_arribada = (1 + SERVICE) / (u * ntc);
+    memset(r, 0, sizeof(*r));
+
+    // Passada sense mesures a dins: events per segon reals
+    for(d = 0; d < dies; d++){
+        ini_alea((unsigned long long) llavor, d);
+        init_stats(&sts, ntc);
+        t0 = ara_ns();
+        simula(ntc, &sts);
+        r->segons += (ara_ns() - t0) / 1e9;
+        free_stats(sts, ntc);
+    }
+
+    // Passada cronometrada, amb les mateixes llavors (els mateixos events)
+    t0 = cost_rellotge();
+    for(d = 0; d < dies; d++){
+        ini_alea((unsigned long long) llavor, d);
+        init_stats(&sts, ntc);
+        dia_cronometrat(ntc, &sts, t0, r);
+        if(d == dies - 1){
+            t0 = ara_ns();
+            collect_stats(sts, ntc);
+            fflush(ofile);
+            r->stats_ns = ara_ns() - t0;
+        }
+        free_stats(sts, ntc);
+    }
+    for(k = 0; k < BENCHTIPUS; k++)
+        r->events += r->n_tipus[k];
+} // executa_punt
+
+// Escriu el punt en JSON
+static void escriu_punt(int ntc, double u, int dies, const spunt_bench *r, long rss){
+    int k;
+
+    printf("    {\"cashiers\": %d, \"load\": %g, \"days\": %d, \"fast_cashiers\": %d,"
+           " \"interarrival\": %.6g,\n", ntc, u, dies, n_rapids, temps_arribada);
+    printf("     \"events\": %lld, \"seconds\": %.6f, \"events_per_sec\": %.0f, \"ns_per_event\": %.2f,\n",
+           r->events, r->segons, r->segons > 0 ? r->events / r->segons : 0.0,
+           r->events > 0 ? r->segons * 1e9 / r->events : 0.0);
+    printf("     \"ns_per_event_type\": {");
+    for(k = 0; k < BENCHTIPUS; k++)
+        printf("%s\"%s\": {\"events\": %lld, \"ns\": %.2f}", k > 0 ? ", " : "", nom_esdev[k],
+               r->n_tipus[k], r->n_tipus[k] > 0 ? r->ns_tipus[k] / r->n_tipus[k] : 0.0);
+    printf("},\n");
+    printf("     \"collect_stats_ns\": %.0f, \"peak_rss_kb\": %ld}", r->stats_ns, rss);
+} // escriu_punt
+
+int main(int argc, char **argv){
+    double caixers[BENCHMAXLLISTA], carrega[BENCHMAXLLISTA], dies[BENCHMAXLLISTA];
+    int nc, nu, nd, i, j, k, opt, primer = 1, estat;
+    const char *lc = BENCHCAIXERS, *lu = BENCHCARREGA, *ld = BENCHDIES;
+    long llavor = RANSEED;
+    spunt_bench r;
+    pid_t fill;
+
+    while((opt = getopt(argc, argv, "n:u:d:s:")) != -1){
+        switch(opt){
+            case 'n': lc = optarg; break;
+            case 'u': lu = optarg; break;
+            case 'd': ld = optarg; break;
+            case 's': llavor = atol(optarg); break;
+            default:
+                fprintf(stderr, "Use: %s [-n caixers,...] [-u carrega,...] [-d dies,...] [-s llavor]\n", argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    nc = llegeix_llista(lc, caixers);
+    nu = llegeix_llista(lu, carrega);
+    nd = llegeix_llista(ld, dies);
+    if(nc == 0 || nu == 0 || nd == 0){
+        fprintf(stderr, "ERROR sim-bench: llistes de valors positius separats per comes\n");
+        exit(EXIT_FAILURE);
+    }
+    for(i = 0; i < nc; i++)
+        if((int) caixers[i] < 2){
+            fprintf(stderr, "ERROR sim-bench: calen com a minim 2 caixers (un de rapid i un de lent)\n");
+            exit(EXIT_FAILURE);
+        }
+    // collect_stats escriu a ofile: el que es mesura es el temps, no el text
+    ofile = fopen("/dev/null", "w");
+    if(ofile == NULL){
+        fprintf(stderr, "ERROR sim-bench: no es pot obrir /dev/null\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("{\n  \"benchmark\": \"sim-bench\", \"seed\": %ld, \"open\": %.1f, \"close\": %.1f,"
+           " \"mean_service\": %d,\n  \"points\": [\n", llavor, OBRIRTIME, TANCARTIME, 1 + SERVICE);
+    for(i = 0; i < nc; i++)
+        for(j = 0; j < nu; j++)
+            for(k = 0; k < nd; k++){
+                printf("%s", primer ? "" : ",\n");
+                primer = 0;
+                fflush(stdout);
+                // Cada punt en un fill: el pic de memoria es nomes seu
+                fill = fork();
+                if(fill < 0){
+                    fprintf(stderr, "ERROR sim-bench: no es pot crear el proces del punt\n");
+                    exit(EXIT_FAILURE);
+                }
+                if(fill == 0){
+                    executa_punt((int) caixers[i], carrega[j], (int) dies[k], llavor, &r);
+                    escriu_punt((int) caixers[i], carrega[j], (int) dies[k], &r, pic_memoria_kb());
+                    fflush(stdout);
+                    _exit(0);
+                }
+                if(waitpid(fill, &estat, 0) < 0 || !WIFEXITED(estat) || WEXITSTATUS(estat) != 0){
+                    fprintf(stderr, "ERROR sim-bench: el punt (%g, %g, %g) ha fallat\n",
+                            caixers[i], carrega[j], dies[k]);
+                    exit(EXIT_FAILURE);
+                }
+            }
+    printf("\n  ]\n}\n");
+    fclose(ofile);
+    return(0);
+} // main
@@ -1,33 +1,174 @@
-/* 
+/*
  * Programa exemple del funcionament d'una simulacio orientada en events
  * basada en el codi donat en el llibre Jorba, Capitol 2
- * 
+ *
  * LLibreria de funcions de l'agenda d'events
- * 
+ *
+ * L'agenda es un monticle binari (heap) de minims ordenat per "quan" que
+ * creix sota demanda. Els events amb el mateix "quan" surten en l'ordre en
+ * que s'han posat (FIFO). Posar i treure un event costa O(log n).
+ *
+ * Cada event pendent ocupa un slot que sap la seva posicio al monticle, de
+ * manera que es pot cancel·lar o reprogramar a partir de l'identificador
+ * (hesdev) que retorna posa_agenda, tambe en O(log n).
+ *
  * File:   agenda.c
- * 
+ *
  * Author: Dolors Sala
  */
 
 #include "sev.h"
 #include "agenda.h"
 
-//static int n_esd;
-static int ara ;  // ultim component plena de l'agenda ordenada de major a menor del 0 a ara
+// Node del monticle: l'event, el seu ordre d'insercio per desempatar i
+// el slot que l'identifica
+typedef struct {
+    esdev e;
+    unsigned long ordre;
+    int slot;
+}nesdev;
+
+// Cada fil te la seva agenda, per poder executar replicacions en paral·lel
+static _Thread_local nesdev *agenda;        // Monticle d'events: agenda[0] es el proxim event
+static _Thread_local int n_esd;             // Capacitat actual de l'agenda
+static _Thread_local int ara ;              // ultima component plena del monticle (-1 agenda buida)
+static _Thread_local unsigned long n_ordre; // Comptador d'insercions per mantenir l'ordre FIFO
+
+static _Thread_local int *pos;              // pos[slot]: posicio al monticle de l'event del slot (NA si lliure)
+static _Thread_local unsigned int *gen;     // gen[slot]: generacio del slot, invalida identificadors antics
+static _Thread_local int *lliures;          // Pila de slots lliures
+static _Thread_local int n_lliures;         // Nombre de slots lliures a la pila
+
+// Cert si el node a s'ha d'executar abans que el node b
+static int abans(nesdev *a, nesdev *b){
+    if (a->e.quan != b->e.quan)
+        return (a->e.quan < b->e.quan);
+    return (a->ordre < b->ordre);
+}
+
+// Converteix un identificador en el seu slot, o NA si l'event ja no es pendent
+static int slot_agenda(hesdev h){
+    int s;
+
+    if (h < 0)
+        return (NA);
+    s = (int)(h & 0xffffffff);
+    if (s >= n_esd || pos[s] == NA || gen[s] != (unsigned int)(h >> 32))
+        return (NA);
+    return (s);
+}
+
+// Allibera el slot s i invalida els identificadors que el referencien.
+// La generacio dona la volta a 2^31 perque l'identificador (gen << 32 | slot)
+// sigui sempre positiu.
+static void allibera_slot(int s){
+    pos[s] = NA;
+    gen[s] = (gen[s] + 1) & 0x7fffffffU;
+    lliures[n_lliures++] = s;
+}
+
+// Demana memoria per n slots a partir del slot primer i els deixa lliures
+static void ini_slots(int primer, int n){
+    int s;
+
+    pos = (int*) realloc(pos, n * sizeof (int));
+    gen = (unsigned int*) realloc(gen, n * sizeof (unsigned int));
+    lliures = (int*) realloc(lliures, n * sizeof (int));
+    if (pos == NULL || gen == NULL || lliures == NULL){
+        puts("Agenda: falta memoria");
+        exit(0);
+    }
+    // els slots baixos queden al cim de la pila
+    for (s = n - 1; s >= primer; s--){
+        pos[s] = NA;
+        gen[s] = 0;
+        lliures[n_lliures++] = s;
+    }
+}
 
 // Inicialitza l'agenda amb n posicions per tenir n events esperant a ser executats
+// Si cal mes espai l'agenda es fa creixer automaticament
 void ini_agenda(int n){
-    //n_esd = n;
-    agenda = (esdev*) malloc(n * sizeof (esdev));
+    n_esd = (n > 0) ? n : 1;
+    agenda = (nesdev*) malloc(n_esd * sizeof (nesdev));
     if (agenda == NULL){
         puts("Agenda: falta memoria");
         exit(0);
     }
+    pos = NULL;
+    gen = NULL;
+    lliures = NULL;
+    n_lliures = 0;
+    ini_slots(0, n_esd);
     ara = -1;
+    n_ordre = 0;
+}
+
+// Dobla la capacitat de l'agenda
+static void creix_agenda(void){
+    nesdev *nova;
+
+    nova = (nesdev*) realloc(agenda, 2 * n_esd * sizeof (nesdev));
+    if (nova == NULL){
+        puts("Agenda: falta memoria");
+        exit(0);
+    }
+    agenda = nova;
+    // tots els slots estan ocupats: nomes els nous queden lliures
+    ini_slots(n_esd, 2 * n_esd);
+    n_esd = 2 * n_esd;
+}
+
+// Col·loca el node n al forat i del monticle pujant-lo cap a l'arrel
+static void puja(int i, nesdev n){
+    int pare;
+
+    for (; i > 0; i = pare){
+        pare = (i - 1) / 2;
+        if (!abans(&n, &agenda[pare]))
+            break;
+        agenda[i] = agenda[pare];
+        pos[agenda[i].slot] = i;
+    }
+    agenda[i] = n;
+    pos[n.slot] = i;
+}
+
+// Col·loca el node n al forat i del monticle baixant-lo cap a les fulles
+static void baixa(int i, nesdev n){
+    int fill;
+
+    for (; (fill = 2 * i + 1) <= ara; i = fill){
+        if (fill < ara && abans(&agenda[fill + 1], &agenda[fill]))
+            fill++;
+        if (!abans(&agenda[fill], &n))
+            break;
+        agenda[i] = agenda[fill];
+        pos[agenda[i].slot] = i;
+    }
+    agenda[i] = n;
+    pos[n.slot] = i;
 }
+
+// Treu del monticle el node de la posicio i
+static void treu_posicio(int i){
+    nesdev darrer;
+
+    allibera_slot(agenda[i].slot);
+    darrer = agenda[ara];
+    --ara;
+    if (i > ara)  // era l'ultim
+        return;
+    if (i > 0 && abans(&darrer, &agenda[(i - 1) / 2]))
+        puja(i, darrer);
+    else
+        baixa(i, darrer);
+}
+
 void imprimir_element_agenda(int i){
-    fprintf(ofile,"(%c, %8.4lf, %2d)",agenda[i].que, agenda[i].quan, agenda[i].on);
+    fprintf(ofile,"(%c, %8.4lf, %2d)",agenda[i].e.que, agenda[i].e.quan, agenda[i].e.on);
 }
+// Imprimeix l'agenda en l'ordre del monticle (el primer es el proxim event)
 void imprimir_agenda(){
     int i;
     fprintf(ofile,"Agenda (%2d): ",ara);
@@ -46,56 +187,143 @@ esdev crea_esdev(int que, float quan, int on){
 }
 
 // Afegeix l'event e a l'agenda ordenat cronologicament segons el "quan"
+// Retorna l'identificador per poder-lo cancel·lar o reprogramar
 // El ta és el temps actual per imprimir en les traces de seguiment
-void posa_agenda(float ta, esdev e) {
-    int i;
-    
+hesdev posa_agenda(float ta, esdev e) {
+    nesdev n;
+
     ++ara;
-    if (ara == N){
-        puts("Error, agenda plena");
-        exit(0);
-    }
-    for (i = ara; i > 0; i--){
-        if(e.quan <= agenda[i-1].quan)
-                break;
-        agenda[i] = agenda[i-1];
-    }
-    agenda[i]=e;
-    
-#if DEBUGagenda == 1 
-   fprintf(ofile,"%.4lf Posa AGENDA %2d: ", ta, ara);
-   imprimir_agenda();
-#endif
+    if (ara == n_esd)
+        creix_agenda();
+    n.e = e;
+    n.ordre = n_ordre++;
+    n.slot = lliures[--n_lliures];
+    puja(ara, n);
+
+    TRACA(TRACAagenda, ta, 'P', e.que, e.on, ara + 1, e.quan);
+    return (((hesdev)gen[n.slot] << 32) | n.slot);
 } // posa_agenda
 
 // Elimina l'element e de l'agenda
 // El ta és el temps actual per imprimir en les traces de seguiment
 int treu_agenda(float ta, esdev *e){
 
-#if DEBUGagenda == 1 
-    fprintf(ofile,"%.4lf Treu AGENDA %2d ", ta, ara);
-    if(ara != -1) imprimir_element_agenda(ara);
-    //fprintf(ofile,": ", ta, ara);
-#endif
     if(ara == -1) {// agenda buida
-        return(0); 
+        return(0);
     }
-    *e = agenda[ara];
-    --ara;
-    
-#if DEBUGagenda == 1 
-    //fprintf(ofile,"%.4lf Treu AGENDA %2d: ", ta, ara);
-    imprimir_agenda();
-#endif
-    
+    *e = agenda[0].e;
+    treu_posicio(0);
+    TRACA(TRACAagenda, ta, 'T', e->que, e->on, ara + 1, e->quan);
+
     return(1);
 }//treu_agenda
 
+// Consulta el proper event de l'agenda sense treure'l
+// Retorna 0 si l'agenda es buida
+int primer_agenda(esdev *e){
+
+    if(ara == -1)
+        return(0);
+    *e = agenda[0].e;
+    return(1);
+}//primer_agenda
+
+// Cancel·la l'event pendent h (p.ex. el client abandona la cua)
+// Retorna 1 si s'ha cancel·lat i 0 si ja no era pendent
+int cancela_agenda(float ta, hesdev h){
+    int s = slot_agenda(h);
+
+    if (s == NA)
+        return(0);
+    TRACA(TRACAagenda, ta, 'C', agenda[pos[s]].e.que, agenda[pos[s]].e.on, ara, agenda[pos[s]].e.quan);
+    treu_posicio(pos[s]);
+    return(1);
+}// cancela_agenda
+
+// Canvia el "quan" de l'event pendent h. Entre events del mateix "quan"
+// passa a ser l'ultim, com si s'acabes de posar. L'identificador es mante.
+// Retorna 1 si s'ha reprogramat i 0 si ja no era pendent
+int reprograma_agenda(float ta, hesdev h, float quan){
+    int s = slot_agenda(h);
+    int i;
+    nesdev n;
+
+    if (s == NA)
+        return(0);
+    i = pos[s];
+    n = agenda[i];
+    n.e.quan = quan;
+    n.ordre = n_ordre++;
+    if (i > 0 && abans(&n, &agenda[(i - 1) / 2]))
+        puja(i, n);
+    else
+        baixa(i, n);
+    TRACA(TRACAagenda, ta, 'R', n.e.que, n.e.on, ara + 1, quan);
+    return(1);
+}// reprograma_agenda
+
+// Retorna 1 si l'event h encara es pendent a l'agenda
+int pendent_agenda(hesdev h){
+    return (slot_agenda(h) != NA);
+}
+
 void buida_agenda(void){
-    ara = -1;
+    while (ara >= 0){
+        allibera_slot(agenda[ara].slot);
+        --ara;
+    }
 }
 
 void allibera_agenda(void){
     free(agenda);
+    free(pos);
+    free(gen);
+    free(lliures);
+    agenda = NULL;
+    pos = NULL;
+    gen = NULL;
+    lliures = NULL;
+    n_esd = 0;
+    n_lliures = 0;
 }
 
+// Desa els events pendents al fitxer f (punt de control), en l'ordre del
+// monticle i amb el seu ordre d'insercio. Retorna 0 si va be i -1 si no.
+int desa_agenda(FILE *f){
+    int i, n = ara + 1, ok;
+
+    ok = fwrite(&n_ordre, sizeof(n_ordre), 1, f) == 1;
+    ok = ok && fwrite(&n, sizeof(n), 1, f) == 1;
+    for (i = 0; ok && i <= ara; i++){
+        ok = fwrite(&agenda[i].e, sizeof(esdev), 1, f) == 1;
+        ok = ok && fwrite(&agenda[i].ordre, sizeof(agenda[i].ordre), 1, f) == 1;
+    }
+    return (ok ? 0 : -1);
+}// desa_agenda
+
+// Crea l'agenda amb els events desats per desa_agenda. Els events surten en
+// el mateix ordre que a la simulacio original, pero els identificadors
+// (hesdev) anteriors no son valids.
+int carrega_agenda(FILE *f){
+    unsigned long ordre;
+    int i, n, ok;
+    nesdev node;
+
+    ok = fread(&ordre, sizeof(ordre), 1, f) == 1;
+    ok = ok && fread(&n, sizeof(n), 1, f) == 1 && n >= 0;
+    if (!ok)
+        return (-1);
+    ini_agenda(n > N ? n : N);
+    for (i = 0; i < n; i++){
+        ok = fread(&node.e, sizeof(esdev), 1, f) == 1;
+        ok = ok && fread(&node.ordre, sizeof(node.ordre), 1, f) == 1;
+        if (!ok)
+            return (-1);
+        // ja venen en ordre de monticle: cada node va a la seva posicio
+        node.slot = lliures[--n_lliures];
+        agenda[++ara] = node;
+        pos[node.slot] = ara;
+    }
+    n_ordre = ordre;
+    return (0);
+}// carrega_agenda
@@ -19,13 +19,22 @@ typedef struct {
     int on;          // caixa/servidor que passa l'esdeveniment
 }esdev;
 
+// Identificador d'un event pendent retornat per posa_agenda. Es valid fins
+// que l'event es treu, es cancel·la o es buida l'agenda (NA si no es valid)
+typedef long long hesdev;
+
 void ini_agenda(int n);
 esdev crea_esdev(int que, float quan, int on);
-void posa_agenda(float ta, esdev e);
+hesdev posa_agenda(float ta, esdev e);
 int treu_agenda(float ta, esdev *e);
+int primer_agenda(esdev *e);
+int cancela_agenda(float ta, hesdev h);
+int reprograma_agenda(float ta, hesdev h, float quan);
+int pendent_agenda(hesdev h);
 void buida_agenda(void);
 void allibera_agenda(void);
+int desa_agenda(FILE *f);
+int carrega_agenda(FILE *f);
 
-static esdev *agenda; // Llista d'events ordenats cronologicament
 #endif	/* AGENDA_H */
 
@@ -8,60 +8,350 @@
  * Author: Dolors Sala
  */
  
+#include <string.h>
 #include "./sev.h"
 #include "./cua.h"
 
 static scua *cues;  //cues ciculars amb assignacio dinamica de memoria
 
+// Bloc de BLOCCUA elements. Els elements d'una cua viuen en una cadena de
+// blocs (cap -> ... -> final) que creix per la cua i s'allibera pel cap.
+struct sbloc {
+    el_cua elem[BLOCCUA];
+    struct sbloc *seg;   // seguent bloc de la cua (o de la llista de lliures)
+};
+
+// Reserva de blocs compartida per totes les cues d'un vector. Els blocs es
+// demanen en trossos de POOLBLOCS i es reciclen: posa_cua i treu_cua no
+// fan cap malloc/free per client.
+struct spool {
+    sbloc *lliures;      // blocs lliures
+    sbloc **trossos;     // trossos reservats (per alliberar-los al final)
+    int ntrossos;
+    int maxtrossos;
+};
+
+#define BITSNIVELLS   4   // nivells del conjunt de bits: fins a 64^4 caixers
+
+// Conjunt de caixers en un bitset jerarquic: bits[0] te un bit per caixer i
+// cada nivell superior te un bit per cada paraula no buida del nivell inferior.
+// Trobar el primer element a partir d'una posicio costa O(nivells).
+typedef struct {
+    int nivells;
+    int nparaules[BITSNIVELLS];
+    unsigned long long *bits[BITSNIVELLS];
+} sbits;
+
+#define MAXCARRILS    2   // rapids i lents
+
+// Carril: rang de caixers entre els quals es tria (els rapids o els lents).
+// Els seus caixers formen un monticle de minims per (lon_cua, caixer): el cap
+// es la cua mes curta i, a igual longitud, la primera.
+typedef struct {
+    int inici, final;    // caixers del carril
+    int *heap;           // caixers del carril en ordre de monticle
+    int *pos;            // pos[c - inici]: posicio del caixer c a heap
+} scarril;
+
+// Index d'un vector de cues per decidir a quin caixer va un client sense
+// recorrer-les totes: els caixers lliures i, per cada carril, el monticle de
+// longituds de cua. posa_cua, treu_cua i posa_caixa el mantenen al dia.
+// La memoria es O(ntc), independent de la longitud de les cues.
+struct sindex {
+    scua *cues;          // vector indexat (la posicio d'una cua es cua - cues)
+    int ntc;
+    sbits lliures;       // caixers amb caixa == 0
+    int ncarrils;
+    scarril carril[MAXCARRILS];
+    int *torn;           // torn[i]: seguent caixer de ENC_RR pel rang que comença a i
+};
+
+// Index del bit menys significatiu a 1 de x (x != 0)
+static int primer_bit(unsigned long long x){
+#if defined(__GNUC__) || defined(__clang__)
+    return(__builtin_ctzll(x));
+#else
+    int i = 0;
+    while((x & 1) == 0){
+        x >>= 1;
+        i++;
+    }
+    return(i);
+#endif
+} // primer_bit
+
+static void crea_bits(sbits *b, int n){
+    int k = 0, m = n;
+
+    do{
+        if(k == BITSNIVELLS){
+            fprintf(stderr, "ERROR index de cues: massa caixers %d\n", n);
+            exit(EXIT_FAILURE);
+        }
+        b->nparaules[k] = (m + 63) / 64;
+        if(b->nparaules[k] == 0)
+            b->nparaules[k] = 1;
+        b->bits[k] = (unsigned long long *) calloc(b->nparaules[k], sizeof(unsigned long long));
+        if(b->bits[k] == NULL){
+            fprintf(stderr, "ERROR index de cues: No hi ha prou memoria\n");
+            exit(EXIT_FAILURE);
+        }
+        m = b->nparaules[k++];
+    }while(m > 1);
+    b->nivells = k;
+} // crea_bits
+
+static void elim_bits(sbits *b){
+    int k;
+    for(k = 0; k < b->nivells; k++)
+        free(b->bits[k]);
+} // elim_bits
+
+static void posa_bit(sbits *b, int i){
+    int k, w;
+    unsigned long long abans;
+
+    for(k = 0; k < b->nivells; k++){
+        w = i >> 6;
+        abans = b->bits[k][w];
+        b->bits[k][w] |= 1ULL << (i & 63);
+        if(abans != 0)
+            break;      // la paraula ja tenia bits: els nivells de sobre no canvien
+        i = w;
+    }
+} // posa_bit
+
+static void treu_bit(sbits *b, int i){
+    int k, w;
+
+    for(k = 0; k < b->nivells; k++){
+        w = i >> 6;
+        b->bits[k][w] &= ~(1ULL << (i & 63));
+        if(b->bits[k][w] != 0)
+            break;      // la paraula encara te bits
+        i = w;
+    }
+} // treu_bit
+
+// Primer element >= i del nivell k, o NA si no n'hi ha
+static int seguent_bit(sbits *b, int k, int i){
+    int w = i >> 6;
+    unsigned long long x;
+
+    if(w >= b->nparaules[k])
+        return(NA);
+    x = b->bits[k][w] & (~0ULL << (i & 63));
+    if(x == 0){
+        if(k + 1 >= b->nivells || k + 1 >= BITSNIVELLS)
+            return(NA);
+        w = seguent_bit(b, k + 1, w + 1);
+        if(w == NA)
+            return(NA);
+        x = b->bits[k][w];
+    }
+    return((w << 6) + primer_bit(x));
+} // seguent_bit
+
+// 1 si la cua del caixer a va abans que la del b al monticle
+static int abans_heap(scua *cues, int a, int b){
+    return(cues[a].lon_cua < cues[b].lon_cua || (cues[a].lon_cua == cues[b].lon_cua && a < b));
+} // abans_heap
+
+// Col·loca el caixer c a la posicio i del monticle del carril k
+static void posa_heap(scarril *k, int i, int c){
+    k->heap[i] = c;
+    k->pos[c - k->inici] = i;
+} // posa_heap
+
+// Puja el caixer de la posicio i mentre vagi abans que el seu pare
+static void puja_heap(sindex *ix, scarril *k, int i){
+    int c = k->heap[i], pare;
+
+    while(i > 0 && abans_heap(ix->cues, c, k->heap[pare = (i - 1) / 2])){
+        posa_heap(k, i, k->heap[pare]);
+        i = pare;
+    }
+    posa_heap(k, i, c);
+} // puja_heap
+
+// Baixa el caixer de la posicio i mentre algun fill vagi abans
+static void baixa_heap(sindex *ix, scarril *k, int i){
+    int c = k->heap[i], f, n = k->final - k->inici + 1;
+
+    while((f = 2 * i + 1) < n){
+        if(f + 1 < n && abans_heap(ix->cues, k->heap[f + 1], k->heap[f]))
+            f++;
+        if(!abans_heap(ix->cues, k->heap[f], c))
+            break;
+        posa_heap(k, i, k->heap[f]);
+        i = f;
+    }
+    posa_heap(k, i, c);
+} // baixa_heap
+
+// Crea el carril dels caixers inici..final. Amb totes les cues buides l'ordre
+// dels caixers ja es un monticle.
+static void crea_carril(scarril *k, int inici, int final){
+    int c, n = final - inici + 1;
+
+    k->inici = inici;
+    k->final = final;
+    k->heap = (int *) malloc((n > 0 ? n : 1) * sizeof(int));
+    k->pos = (int *) malloc((n > 0 ? n : 1) * sizeof(int));
+    if(k->heap == NULL || k->pos == NULL){
+        fprintf(stderr, "ERROR index de cues: No hi ha prou memoria\n");
+        exit(EXIT_FAILURE);
+    }
+    for(c = inici; c <= final; c++)
+        posa_heap(k, c - inici, c);
+} // crea_carril
+
+// Crea l'index del vector de ntc cues buides amb caixers lliures. Els carrils
+// son els rangs que fa servir l'encaminament: rapids 0..n_rapids-1 i lents
+// n_rapids..ntc-1 (un de sol si n_rapids no parteix el vector).
+static sindex *crea_index(scua *cues, int ntc){
+    sindex *ix;
+    int c;
+
+    ix = (sindex *) malloc(sizeof(sindex));
+    if(ix != NULL)
+        ix->torn = (int *) malloc(ntc * sizeof(int));
+    if(ix == NULL || ix->torn == NULL){
+        fprintf(stderr, "ERROR index de cues: No hi ha prou memoria\n");
+        exit(EXIT_FAILURE);
+    }
+    ix->cues = cues;
+    ix->ntc = ntc;
+    crea_bits(&ix->lliures, ntc);
+    for(c = 0; c < ntc; c++){
+        posa_bit(&ix->lliures, c);
+        ix->torn[c] = c;
+    }
+    if(n_rapids > 0 && n_rapids < ntc){
+        ix->ncarrils = 2;
+        crea_carril(&ix->carril[0], 0, n_rapids - 1);
+        crea_carril(&ix->carril[1], n_rapids, ntc - 1);
+    }else{
+        ix->ncarrils = 1;
+        crea_carril(&ix->carril[0], 0, ntc - 1);
+    }
+    return(ix);
+} // crea_index
+
+static void elim_index(sindex *ix){
+    int k;
+
+    elim_bits(&ix->lliures);
+    for(k = 0; k < ix->ncarrils; k++){
+        free(ix->carril[k].heap);
+        free(ix->carril[k].pos);
+    }
+    free(ix->torn);
+    free(ix);
+} // elim_index
+
+// La longitud de la cua passa de abans a lon_cua: O(log ntc)
+static void canvia_lon_index(scua *cua, int abans){
+    sindex *ix = cua->index;
+    int c = (int)(cua - ix->cues);
+    scarril *k = &ix->carril[(ix->ncarrils > 1 && c >= ix->carril[1].inici) ? 1 : 0];
+
+    if(cua->lon_cua < abans)
+        puja_heap(ix, k, k->pos[c - k->inici]);
+    else
+        baixa_heap(ix, k, k->pos[c - k->inici]);
+} // canvia_lon_index
+
+static spool *crea_pool(void){
+    spool *pool = (spool *) calloc(1, sizeof(spool));
+
+    if(pool == NULL){
+        fprintf(stderr, "ERROR Crea cua: No hi ha prou memoria per la reserva de blocs\n");
+        exit(EXIT_FAILURE);
+    }
+    return(pool);
+} // crea_pool
+
+static void elim_pool(spool *pool){
+    int t;
+
+    for(t = 0; t < pool->ntrossos; t++)
+        free(pool->trossos[t]);
+    free(pool->trossos);
+    free(pool);
+} // elim_pool
+
+// Agafa un bloc lliure; si no n'hi ha, reserva un tros de POOLBLOCS blocs
+static sbloc *agafa_bloc(spool *pool){
+    sbloc *b, **t;
+    int i;
+
+    if(pool->lliures == NULL){
+        if(pool->ntrossos == pool->maxtrossos){
+            pool->maxtrossos = (pool->maxtrossos > 0) ? 2 * pool->maxtrossos : 4;
+            t = (sbloc **) realloc(pool->trossos, pool->maxtrossos * sizeof(sbloc *));
+            if(t == NULL){
+                fprintf(stderr, "ERROR Posa cua: No hi ha prou memoria per la reserva de blocs\n");
+                exit(EXIT_FAILURE);
+            }
+            pool->trossos = t;
+        }
+        b = (sbloc *) malloc(POOLBLOCS * sizeof(sbloc));
+        if(b == NULL){
+            fprintf(stderr, "ERROR Posa cua: No hi ha prou memoria per la reserva de blocs\n");
+            exit(EXIT_FAILURE);
+        }
+        pool->trossos[pool->ntrossos++] = b;
+        for(i = 0; i < POOLBLOCS; i++){
+            b[i].seg = pool->lliures;
+            pool->lliures = &b[i];
+        }
+    }
+    b = pool->lliures;
+    pool->lliures = b->seg;
+    b->seg = NULL;
+    return(b);
+} // agafa_bloc
+
+// Torna el bloc b a la llista de lliures de la reserva
+static void torna_bloc(spool *pool, sbloc *b){
+    b->seg = pool->lliures;
+    pool->lliures = b;
+} // torna_bloc
+
 // Imprimeix l'element de la cua que es passa com a paràmetre
 void imprimir_element_cua(el_cua elem){
     //printf(ofile,"(%7.4lf %7.4lf) ", elem.tar, elem.tse);
     fprintf(ofile,"%7.4lf ", elem.tar);
 }
 
-// Imprimeix la cua circular
+// Imprimeix la cua (ajuda per depurar, fora del cami habitual)
 void imprimir_cua(scua cua){
-    int i, f;
-#if DEBUGcua == 1
+    sbloc *b;
+    int i, pos;
     fprintf(ofile,"Cua %d (I %2d,F %2d, L %2d): ", 
             cua.idcua, cua.ini_cua, cua.fin_cua, cua.lon_cua);
-    if (cua.fin_cua >= cua.ini_cua)
-        f = cua.fin_cua;
-    else
-        f = CUA_MAX-1;
-#if 0
-    if(cua.lon_cua > 0){
-        for (i = cua.ini_cua; i <= f; i++){
-            imprimir_element_cua(cua.elem[i]);
-        }
-        if(f != cua.fin_cua){
-            for (i = 0; i <= cua.fin_cua; i++){
-                imprimir_element_cua(cua.elem[i]);
-            }
-        }
-    }
-#else      
-    int pos = 0;
+    b = cua.cap;
+    pos = cua.ini_cua;
     for (i = 0; i < long_cua(cua); i++){
-        pos = ((cua.ini_cua + i) % CUA_MAX);
-        imprimir_element_cua(cua.elem[pos]);
+        if(pos == BLOCCUA){
+            b = b->seg;
+            pos = 0;
+        }
+        imprimir_element_cua(b->elem[pos++]);
     }
-#endif
     
     fprintf(ofile,"\n");
-#endif
 }
 
 // Imprimeix les ntc cues
 void imprimir_cues(scua *cues, int ntc){
-    int i, f, c;
-#if DEBUGcua == 1
+    int c;
     for(c = 0; c < ntc; c++){
         //fprintf(ofile,"Cua %d ", cues[c].idcua);
         imprimir_cua(cues[c]);
     }
     fprintf(ofile,"\n");
-#endif
 }
 
 // Crea un element de la cua
@@ -70,89 +360,118 @@ el_cua crea_element_cua(float tar, float tse){
     
     c.tar = tar;
     c.tse = tse;
+    c.lon = 0;
     return(c);
 }//crea_element_cua
 
-// Crea una cua circular buida de capacitat per max_cua elements
-void crea_cua(scua *cua, int max, int idcua){
-    int c;
-    cua->elem = (el_cua*)malloc(max * sizeof(el_cua));
-    if (cua == NULL){
-        fprintf(ofile,"ERROR Crea cua %d: No hi ha prou memoria per crear cua buida", c);
-        exit(0);
-    }
-    if (cua->elem == NULL){
-        fprintf(stderr, "ERROR Crea cua %d: No hi ha prou memoria per crear cua buida\n", idcua);
-        exit(EXIT_FAILURE);
-    }
-    
+// Crea una cua buida que agafa els blocs de la reserva pool
+static void crea_cua(scua *cua, spool *pool, int idcua){
     cua->idcua = idcua;
     cua->ini_cua = -1;
     cua->fin_cua = -1;
     cua->lon_cua = 0; 
-    cua->max_cua = max;
+    cua->cap     = NULL;
+    cua->final   = NULL;
+    cua->pool    = pool;
     cua->caixa   = 0;
+    cua->fi_servei = 0;
+    cua->treball = 0.0;
+    cua->tcanvi  = 0;
+    cua->index   = NULL;
 }//crea_cua
 
-// Crea totes les cues circulars buides de capacitat per max_cua elements
+// Crea totes les cues buides. Les cues creixen sota demanda amb blocs d'una
+// reserva comuna; max es la longitud prevista (ni les cues ni l'index en depenen).
 void crea_cues(scua **pcua, int max, int ntc){
     scua *cues = *pcua;
+    spool *pool;
     int c;
     cues = (scua*) malloc(ntc * sizeof(scua));
     if (cues == NULL){
         puts("ERROR Crea cua : No hi ha prou memoria per crear cua buida");
         exit(0);
     }
+    pool = crea_pool();
     for(c = 0; c < ntc; c++)
-        crea_cua(&cues[c], max, c);
-    imprimir_cues(cues, ntc);
+        crea_cua(&cues[c], pool, c);
+    (void) max;
+    cues[0].index = crea_index(cues, ntc);
+    for(c = 1; c < ntc; c++)
+        cues[c].index = cues[0].index;
     *pcua = cues;
 }//crea_cues
 
-//Inserta un valor "c" a la cua circular cua
+// Canvia l'estat de la caixa (1 ocupada, 0 lliure) mantenint l'index
+void posa_caixa(scua *cua, int estat){
+    int c;
+
+    if(cua->caixa == estat)
+        return;
+    cua->caixa = estat;
+    if(cua->index != NULL){
+        c = (int)(cua - cua->index->cues);
+        if(estat == 0)
+            posa_bit(&cua->index->lliures, c);
+        else
+            treu_bit(&cua->index->lliures, c);
+    }
+}//posa_caixa
+
+//Inserta un valor "c" al final de la cua; si l'ultim bloc es ple n'hi
+// encadena un de la reserva. Cost O(1) i mai falla per manca d'espai.
 // El ta és el temps actual per imprimir en les traces de seguiment.
 int posa_cua(scua *cua, float ta, el_cua c){
-    if (cua->lon_cua == cua->max_cua) {
-        fprintf(ofile,"ERROR CUA %d: No hi ha espai a la cua. Incrementa max_cua", cua->idcua);
-        exit(0);
+    sbloc *b;
+
+    if(cua->final == NULL || cua->fin_cua == BLOCCUA - 1){
+        b = agafa_bloc(cua->pool);
+        if(cua->final == NULL){
+            cua->cap = b;
+            cua->ini_cua = 0;
+        }else
+            cua->final->seg = b;
+        cua->final = b;
+        cua->fin_cua = -1;
     }
-    
-    cua->fin_cua++;
-    if(cua->fin_cua == cua->max_cua) cua->fin_cua = 0; // Primer element a la cua
-    if(cua->lon_cua == 0) cua->ini_cua = cua->fin_cua;
+    cua->final->elem[++cua->fin_cua] = c;
     ++cua->lon_cua;
-  
-    cua->elem[cua->fin_cua] = c;
+    cua->treball += c.tse;
+    if(cua->index != NULL)
+        canvia_lon_index(cua, cua->lon_cua - 1);
 
-#if DEBUGcua == 1
-    fprintf(ofile,"%.4lf POSA CUA %d... pos %2d elem %7.4lf ", 
-            ta, cua->idcua, cua->fin_cua, c.tar);
-#endif
-        
-    imprimir_cua(*cua);
+    TRACA(TRACAcua, ta, 'P', 0, cua->idcua, cua->lon_cua, c.tar);
     return (1);
 }// posa_cua
 
-// Treure el seguent element de la cua circular cua i el retorna a c
+// Treure el seguent element de la cua i el retorna a c. Els blocs que
+// queden buits tornen a la reserva. El client comença el servei a ta.
 // El ta és el temps actual per imprimir en les traces de seguiment.
 int treu_cua(scua *cua, float ta, el_cua *c){
+    sbloc *b;
     int ret = 1; 
     
     if(cua->lon_cua == 0) {
         ret = 0;
     }
     else { // si hi ha elements a la cua
-#if DEBUGcua == 1
-        fprintf(ofile,"%.4lf TREU CUA %d... pos %2d ", ta, cua->idcua, cua->ini_cua);
-        if(cua->lon_cua > 0) imprimir_element_cua(cua->elem[cua->ini_cua]);
-        fprintf(ofile,"(long %d) ", cua->lon_cua);
-#endif
-        *c = cua->elem[cua->ini_cua];
-        ++cua->ini_cua;
-        if (cua->ini_cua == cua->max_cua) cua->ini_cua = 0;
+        *c = cua->cap->elem[cua->ini_cua++];
         --cua->lon_cua;
-        if(cua->lon_cua == 0) cua->ini_cua = cua->fin_cua = -1;
-        imprimir_cua(*cua);
+        cua->treball -= c->tse;
+        cua->fi_servei = ta + c->tse;
+        if(cua->lon_cua == 0){
+            cua->treball = 0.0;
+            torna_bloc(cua->pool, cua->cap);
+            cua->cap = cua->final = NULL;
+            cua->ini_cua = cua->fin_cua = -1;
+        }else if(cua->ini_cua == BLOCCUA){
+            b = cua->cap;
+            cua->cap = b->seg;
+            cua->ini_cua = 0;
+            torna_bloc(cua->pool, b);
+        }
+        if(cua->index != NULL)
+            canvia_lon_index(cua, cua->lon_cua + 1);
+        TRACA(TRACAcua, ta, 'T', 0, cua->idcua, cua->lon_cua, c->tar);
     }
     return(ret);
 }// treu_cua
@@ -162,9 +481,17 @@ int long_cua(scua cua){
     return(cua.lon_cua);
 }
 
-//Allibera l'espai de la cua circular "cua"
-void elim_cua(scua *cua){
-    free(cua->elem);
+//Torna a la reserva els blocs de la cua "cua"
+static void elim_cua(scua *cua){
+    sbloc *b;
+
+    while(cua->cap != NULL){
+        b = cua->cap;
+        cua->cap = b->seg;
+        torna_bloc(cua->pool, b);
+    }
+    cua->final = NULL;
+    cua->lon_cua = 0;
 }
 
 //Allibera l'espai de totes (ntc) les cues
@@ -172,51 +499,216 @@ void elim_cues(scua *cues, int ntc){
     int c;
     for(c = 0; c < ntc; c++)
         elim_cua(&cues[c]);
+    if(ntc > 0 && cues[0].index != NULL)
+        elim_index(cues[0].index);
+    if(ntc > 0)
+        elim_pool(cues[0].pool);
     free(cues);
 }
 
+// Desa l'estat de les ntc cues al fitxer f (punt de control): estat de
+// cada caixa, clients a la cua i el torn de ENC_RR. Retorna 0 si va be.
+int desa_cues(FILE *f, scua *cues, int ntc){
+    sbloc *b;
+    int c, i, pos, ok = 1;
+
+    for(c = 0; ok && c < ntc; c++){
+        ok = fwrite(&cues[c].caixa, sizeof(int), 1, f) == 1;
+        ok = ok && fwrite(&cues[c].fi_servei, sizeof(float), 1, f) == 1;
+        ok = ok && fwrite(&cues[c].tcanvi, sizeof(float), 1, f) == 1;
+        ok = ok && fwrite(&cues[c].treball, sizeof(double), 1, f) == 1;
+        ok = ok && fwrite(&cues[c].lon_cua, sizeof(int), 1, f) == 1;
+        b = cues[c].cap;
+        pos = cues[c].ini_cua;
+        for(i = 0; ok && i < cues[c].lon_cua; i++){
+            if(pos == BLOCCUA){
+                b = b->seg;
+                pos = 0;
+            }
+            ok = fwrite(&b->elem[pos++], sizeof(el_cua), 1, f) == 1;
+        }
+    }
+    if(ok && ntc > 0 && cues[0].index != NULL)
+        ok = fwrite(cues[0].index->torn, sizeof(int), ntc, f) == (size_t) ntc;
+    return(ok ? 0 : -1);
+} // desa_cues
+
+// Crea les ntc cues amb l'estat desat per desa_cues
+int carrega_cues(FILE *f, scua **pcua, int ntc){
+    scua *cua;
+    el_cua e;
+    double treball;
+    int c, i, n, estat, ok = 1;
+
+    crea_cues(pcua, CUA_MAX, ntc);
+    for(c = 0; ok && c < ntc; c++){
+        cua = &(*pcua)[c];
+        ok = fread(&estat, sizeof(int), 1, f) == 1;
+        ok = ok && fread(&cua->fi_servei, sizeof(float), 1, f) == 1;
+        ok = ok && fread(&cua->tcanvi, sizeof(float), 1, f) == 1;
+        ok = ok && fread(&treball, sizeof(double), 1, f) == 1;
+        ok = ok && fread(&n, sizeof(int), 1, f) == 1 && n >= 0;
+        if(ok)
+            posa_caixa(cua, estat);
+        for(i = 0; ok && i < n; i++){
+            ok = fread(&e, sizeof(el_cua), 1, f) == 1;
+            if(ok)
+                posa_cua(cua, cua->tcanvi, e);
+        }
+        // el valor acumulat original, no la suma refeta per posa_cua
+        cua->treball = treball;
+    }
+    if(ok && ntc > 0 && (*pcua)[0].index != NULL)
+        ok = fread((*pcua)[0].index->torn, sizeof(int), ntc, f) == (size_t) ntc;
+    return(ok ? 0 : -1);
+} // carrega_cues
+
 // Decideix a quina cua/caixer posar el nou client
-// la cua amb menys clients esperant
+// la cua amb menys clients esperant (a igual longitud, la primera).
+// Si el rang es un carril de l'index la resposta es el cap del monticle: O(1)
 int cua_mes_curta(scua *cues, int inici, int final){
-    int c;
-    el_cua e;
-    int millor = inici;
-    int minlong = long_cua(cues[inici]);
+    int c, k, d;
+    sindex *ix = (inici <= final) ? cues[inici].index : NULL;
     
-    // En principi la de menys clients és la primera)
-    //e.on  = 0;
-    //e.tar = long_cua(cues[e.on]);
+    if(ix != NULL){
+        d = (int)(cues - ix->cues);
+        for(k = 0; k < ix->ncarrils; k++)
+            if(ix->carril[k].inici == inici + d && ix->carril[k].final == final + d)
+                return(ix->carril[k].heap[0] - d);
+    }
     
-    // recorre resta de cues per identificar la més curta
+    // Sense index o rang que no es un carril: recorre les cues per identificar la més curta
+    int millor = inici;
+    int minlong = long_cua(cues[inici]);
     for(c = inici + 1; c <= final; c++){
         if (long_cua(cues[c]) < minlong){
             millor = c;
             minlong = long_cua(cues[c]);
         }
-#if (DEBUG-quina-cua == 1)
-        fprintf(ofile, "Quina cua? Cua %d long %d (minim: cua %d long %d)\n", 
-                c, cues[c].lon_cua, e.on, e.tar);
-#endif
     } 
-#if (DEBUGquinaCua == 1)
-       // fprintf(ofile, "Quina cua? Cua %d long %f !!!!!!!!!\n", e.on, e.tar);
-#endif
     return millor;
 } // cua_mes_curta
 
+// Retorna el primer caixer lliure entre inici i final, o NA si no n'hi ha
 int primer_caixer_buit(scua *cues, int inici, int final){
     int c = inici;
     int ret = NA;
+    sindex *ix = (inici <= final) ? cues[inici].index : NULL;
 
+    if(ix != NULL){
+        c = seguent_bit(&ix->lliures, 0, inici + (int)(cues - ix->cues));
+        if(c != NA && (c -= (int)(cues - ix->cues)) <= final)
+            ret = c;
+        return(ret);
+    }
     while(c <= final && cues[c].caixa != 0)
         c++;
     if(c <= final)
         ret = c;
     else
         ret = NA;
-#if (DEBUGquinaCua == 1)
-    fprintf(ofile, "Primer Caixer Buit %d \n", ret);
-#endif
    return(ret);
 
 } // primer_caixer_buit
+
+// Treball pendent del caixer a l'instant ta: el que resta del servei en
+// curs mes els temps de servei dels clients que esperen
+static double treball_pendent(scua *cua, float ta){
+    double w = cua->treball;
+
+    if(cua->caixa != 0 && cua->fi_servei > ta)
+        w += (double) cua->fi_servei - (double) ta;
+    return(w);
+} // treball_pendent
+
+// ENC_JSQ: el primer caixer lliure o, si no n'hi ha, la cua mes curta
+static int encamina_jsq(scua *cues, int inici, int final, float ta){
+    int c = primer_caixer_buit(cues, inici, final);
+
+    (void) ta;
+    return((c != NA) ? c : cua_mes_curta(cues, inici, final));
+} // encamina_jsq
+
+// ENC_JSQD: mostreja enc_d caixers (amb reemplaçament) i tria el que te
+// menys clients (a igualtat, el primer mostrejat). Cost O(d).
+static int encamina_jsqd(scua *cues, int inici, int final, float ta){
+    int k, c, l, millor = inici, lmin = 0;
+    int n = final - inici + 1;
+
+    (void) ta;
+    for(k = 0; k < enc_d; k++){
+        c = inici + (int)(alea(ALEA_ENCAMINA) * n);
+        if(c > final)
+            c = final;
+        l = cues[c].lon_cua + cues[c].caixa;
+        if(k == 0 || l < lmin){
+            millor = c;
+            lmin = l;
+        }
+    }
+    return(millor);
+} // encamina_jsqd
+
+// ENC_RR: els caixers del rang per torn, sense mirar-ne l'estat
+static int encamina_rr(scua *cues, int inici, int final, float ta){
+    sindex *ix = cues[inici].index;
+    int *torn, c;
+
+    if(ix == NULL)
+        return(encamina_jsq(cues, inici, final, ta));
+    torn = &ix->torn[inici + (int)(cues - ix->cues)];
+    c = *torn - (int)(cues - ix->cues);
+    if(c < inici || c > final)
+        c = inici;
+    *torn = ((c < final) ? c + 1 : inici) + (int)(cues - ix->cues);
+    return(c);
+} // encamina_rr
+
+// ENC_LWL: el caixer amb menys treball pendent (a igualtat, el primer)
+static int encamina_lwl(scua *cues, int inici, int final, float ta){
+    int c, millor = inici;
+    double w, wmin = treball_pendent(&cues[inici], ta);
+
+    for(c = inici + 1; c <= final; c++){
+        w = treball_pendent(&cues[c], ta);
+        if(w < wmin){
+            millor = c;
+            wmin = w;
+        }
+    }
+    return(millor);
+} // encamina_lwl
+
+typedef int (*fencamina)(scua *cues, int inici, int final, float ta);
+
+// Politiques d'encaminament, en l'ordre de les constants ENC_*
+static const struct {
+    const char *nom;
+    fencamina tria;
+} politiques[] = {
+    { "jsq",  encamina_jsq  },
+    { "jsqd", encamina_jsqd },
+    { "rr",   encamina_rr   },
+    { "lwl",  encamina_lwl  }
+};
+#define NPOLITIQUES ((int)(sizeof(politiques) / sizeof(politiques[0])))
+
+// Decideix a quin caixer entre inici i final va el client que arriba a ta
+// segons la politica d'encaminament. El caixer pot estar lliure o no.
+int tria_cua(scua *cues, int inici, int final, float ta){
+    return(politiques[politica].tria(cues, inici, final, ta));
+} // tria_cua
+
+// Retorna la politica amb el nom donat, o NA si no n'hi ha cap
+int politica_encaminament(const char *nom){
+    int p;
+
+    for(p = 0; p < NPOLITIQUES; p++)
+        if(strcmp(nom, politiques[p].nom) == 0)
+            return(p);
+    return(NA);
+} // politica_encaminament
+
+const char *nom_politica(int p){
+    return((p >= 0 && p < NPOLITIQUES) ? politiques[p].nom : "?");
+} // nom_politica
@@ -16,7 +16,14 @@ void crea_cues(scua **pcua, int max, int ntc);
 int posa_cua(scua *cua, float ta, el_cua c);
 int treu_cua(scua *cua, float ta, el_cua *c);
 int long_cua(scua cua);
+void posa_caixa(scua *cua, int estat);
+void elim_cues(scua *cues, int ntc);
 int cua_mes_curta(scua *cues, int inici, int final);
 int primer_caixer_buit(scua *cues, int inici, int final);
+int tria_cua(scua *cues, int inici, int final, float ta);
+int politica_encaminament(const char *nom);
+const char *nom_politica(int p);
+int desa_cues(FILE *f, scua *cues, int ntc);
+int carrega_cues(FILE *f, scua **pcua, int ntc);
 #endif	/* CUA_H */
 
@@ -0,0 +1,173 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Model del supermercat escrit amb processos (proces.h) en lloc del
+ * switch d'events de sev.c: un proces genera les arribades i cada client
+ * es un proces que tria caixer, l'espera (WAIT_FOR), es serveix (HOLD) i
+ * el deixa al seguent (RELEASE). Fa servir els mateixos fluxos aleatoris,
+ * la mateixa politica d'encaminament i les mateixes estadistiques que
+ * simula, i les cues (scua) es mantenen igual perque l'encaminament i les
+ * estadistiques de longitud de cua les necessiten. Dona els mateixos
+ * resultats que el motor d'events.
+ *
+ * File:   model_proces.c
+ * Author: Dolors Sala
+ */
+
+#include "sev.h"
+#include "cua.h"
+#include "agenda.h"
+#include "stats.h"
+#include "registre.h"
+#include "proces.h"
+#include "tiquets.h"
+#include "perfil.h"
+#include "telemetria.h"
+
+// Estat compartit pels processos d'una simulacio (privat de cada fil)
+typedef struct {
+    int ntc;
+    scua *cues;          // cues dels caixers (encaminament i estadistiques)
+    srecurs *caixers;    // cada caixer es un recurs
+    sstats *sts;
+} smodel;
+
+// Estat propi d'un client
+typedef struct {
+    float tar;           // arribada al supermercat
+    float tse;           // temps de servei
+    int caixer;
+    int classe;          // 1 rapid, 0 lent
+    int lon;             // clients a la cua quan hi entra
+    int de_cua;          // ha hagut d'esperar
+    long long tiquet;    // tiquet del client (amb -t)
+} sclient;
+
+// Estat propi del generador d'arribades
+typedef struct {
+    float t;             // seguent arribada
+    long long i;         // tiquet de la seguent arribada (amb -t)
+} sgenerador;
+
+static _Thread_local smodel m;
+
+// Cicle de vida d'un client
+static void client(sproces *p, float ta){
+    sclient *c = (sclient *) &p->dades;
+    el_cua e;
+    int ini, fin;
+
+    PROC_INICI(p);
+    // Decideix si el client es ràpid o lent (fraccio_rapids, 30% per defecte) i tria el caixer
+    c->tar = ta;
+    c->classe = (tiquets != NULL) ? classe_tiquet(c->tiquet) : (alea(ALEA_CLASSE) < fraccio_rapids) ? 1 : 0;
+    ini = c->classe ? 0 : n_rapids;
+    fin = c->classe ? n_rapids - 1 : m.ntc - 1;
+    c->caixer = tria_cua(m.cues, ini, fin, ta);
+    c->tse = (tiquets != NULL) ? servei_tiquet(c->tiquet, c->caixer) : temps_servei(c->caixer);
+    TRACA(TRACAalea, ta, 'S', PROCES, c->caixer, 0, c->tse);
+    inc_ombra(m.sts, ini, fin, ta, c->tse - 1);   // variable de control (-v)
+    if (m.caixers[c->caixer].propietari != NA){   // caixer ocupat: fa cua
+        c->de_cua = 1;
+        c->lon = m.cues[c->caixer].lon_cua;
+        TRACA(TRACAquinaCua, ta, 'C', PROCES, c->caixer, c->lon, c->classe);
+        e = crea_element_cua(ta, c->tse);
+        e.on = c->caixer;
+        e.lon = c->lon;
+        actualitzar_stats_caixer(&m.cues[c->caixer], c->caixer, ta, m.sts);
+        posa_cua(&m.cues[c->caixer], ta, e);
+    }
+    WAIT_FOR(p, &m.caixers[c->caixer]);
+
+    // Comença el servei
+    if (c->de_cua){
+        treu_cua(&m.cues[c->caixer], ta, &e);
+        inc_servei(m.sts, c->caixer, ta, ta - c->tar, c->tse, 1);
+        TRACA(TRACAserv, ta, 'E', PROCES, c->caixer, m.cues[c->caixer].lon_cua, ta - c->tar);
+    }else{
+        TRACA(TRACAquinaCua, ta, 'B', PROCES, c->caixer, 0, c->classe);
+        posa_caixa(&m.cues[c->caixer], 1);
+        m.cues[c->caixer].fi_servei = ta + c->tse;
+        inc_servei(m.sts, c->caixer, ta, 0, c->tse, 0);
+    }
+    TRACA(TRACAserv, ta, 'S', PROCES, c->caixer, m.cues[c->caixer].lon_cua, c->tse);
+    REGISTRA_CLIENT(c->tar, c->classe, c->caixer, c->lon, ta, c->tse);
+    HOLD(p, ta, c->tse);
+
+    // Surt del supermercat i deixa el caixer al seguent de la cua
+    inc_atesos(m.sts, c->caixer, ta);
+    if (m.cues[c->caixer].lon_cua > 0)
+        actualitzar_stats_caixer(&m.cues[c->caixer], c->caixer, ta, m.sts);
+    else
+        posa_caixa(&m.cues[c->caixer], 0);
+    RELEASE(p, &m.caixers[c->caixer], ta);
+    PROC_FI(p);
+} // client
+
+// Genera les arribades mentre el supermercat es obert (o queden tiquets)
+static void arribades(sproces *p, float ta){
+    sgenerador *g = (sgenerador *) &p->dades;
+    sproces *q;
+
+    PROC_INICI(p);
+    g->i = 0;
+    g->t = (tiquets != NULL) ? tiquets[0].temps : seguent_arribada(ta);
+    while ((tiquets != NULL) ? g->i < n_tiquets : g->t < TANCARTIME){
+        HOLD_UNTIL(p, g->t);
+        q = crea_proces(client);
+        ((sclient *) &q->dades)->tiquet = g->i;
+        activa_proces(q, ta);
+        if (tiquets != NULL){
+            if (++g->i < n_tiquets)
+                g->t = tiquets[g->i].temps;
+        }else
+            g->t = seguent_arribada(ta);
+        TRACA(TRACAalea, ta, 'A', PROCES, NA, 0, g->t - ta);
+    }
+    PROC_FI(p);
+} // arribades
+
+// Executa una replicacio de la simulacio amb ntc caixers fent servir el
+// model de processos i acumula les estadistiques a sts (com simula)
+int simula_processos(int ntc, sstats *sts){
+    esdev e;
+    float ta = 0;
+    int c, ret = 0;
+
+    m.ntc = ntc;
+    m.sts = sts;
+    m.cues = NULL;
+    crea_cues(&m.cues, CUA_MAX, ntc);
+    m.caixers = (srecurs *) malloc(ntc * sizeof(srecurs));
+    if (m.caixers == NULL)
+        ERROR((ofile, "ERROR: allocating memory in simula_processos\n"));
+    for (c = 0; c < ntc; c++)
+        ini_recurs(&m.caixers[c]);
+    ini_agenda(N);
+
+    programa_proces(crea_proces(arribades), OBRIRTIME);
+    while (ret == 0 && treu_agenda(ta, &e) != 0){
+        if (e.que == PROCES){
+            ta = e.quan;
+            repren_proces(e.on, ta);
+            TELEMETRIA(ta, m.cues, ntc, sts);
+        }else{
+            fprintf(ofile,"ERROR: esdeveniment desconegut %d\n",e.que);
+            bolca_traca(TRACAFILENAME);
+            ret = -1;
+        }
+    }
+
+    // Temps de cada cua amb la longitud final fins a l'ultim event
+    actualitzar_stats_cua(m.cues, ntc, ta, sts);
+    publica_telemetria(ta, m.cues, ntc, sts, 1);
+    tanca_mser(sts);
+    elim_cues(m.cues, ntc);
+    for (c = 0; c < ntc; c++)
+        elim_recurs(&m.caixers[c]);
+    free(m.caixers);
+    allibera_agenda();
+    allibera_processos();
+    return (ret);
+} // simula_processos
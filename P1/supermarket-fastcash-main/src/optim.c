@@ -0,0 +1,342 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Optimitzador de personal (-z objectiu). Busca la configuracio (caixers,
+ * caixers rapids, fraccio de clients rapids) amb menys caixers que
+ * compleix l'objectiu sobre el temps de cua i, entre les que en tenen
+ * tants, la de menys temps de cua.
+ *
+ * Es proven els nivells de personal de 2 caixers fins al maxim (-n) en
+ * ordre. A cada nivell es simulen totes les configuracions amb numeros
+ * aleatoris comuns: la replicacio r de totes fa servir ini_alea(llavor, r),
+ * i com que cada proposit te el seu flux (arribades, classe, servei de
+ * cada caixer) les configuracions veuen els mateixos clients. Despres de
+ * OPTN0 replicacions s'afegeixen replicacions nomes a les configuracions
+ * vives i a cada etapa se'n descarten:
+ *   - les que no compleixen l'objectiu (l'interval unilateral queda per
+ *     sobre) i
+ *   - les clarament pitjors que una altra, amb el procediment sequencial
+ *     de Kim i Nelson (KN) amb zona d'indiferencia OPTDELTA * objectiu.
+ * El nivell s'acaba quan en queda una amb la factibilitat decidida o quan
+ * s'arriba a OPTMAXREP replicacions. Les replicacions d'una etapa
+ * (configuracio, replicacio) s'executen en paral·lel en nfils fils.
+ *
+ * File:   optim.c
+ * Author: Dolors Sala
+ */
+
+#include <string.h>
+#include <pthread.h>
+#include "sev.h"
+#include "stats.h"
+#include "replica.h"
+#include "optim.h"
+
+#define OPT_VIVA        0
+#define OPT_DESCARTADA  1   // pitjor que una altra (KN)
+#define OPT_INFACTIBLE  2   // no compleix l'objectiu
+
+static const char *nom_estat[3] = {"viva", "descartada", "no compleix"};
+
+// Una configuracio candidata i les seves observacions
+typedef struct {
+    int ntc;
+    int rapids;
+    double fraccio;
+    double y[OPTMAXREP];   // mesura de cada replicacio
+    int r;                 // replicacions fetes
+    int estat;             // OPT_VIVA, OPT_DESCARTADA o OPT_INFACTIBLE
+    int factible;          // l'interval confirma que compleix l'objectiu
+    double mitjana, ic;    // mitjana de les r replicacions i semiamplada (unilateral)
+} scandidat;
+
+// Treballs d'una etapa, repartits entre els fils
+typedef struct {
+    scandidat *c;
+    int *cand;             // candidat i replicacio de cada treball [nfeina]
+    int *rep;
+    int nfeina;
+    int seguent;           // seguent treball per executar
+    int mesura;            // OPT_MITJANA o OPT_P95
+    unsigned long long llavor;
+    int ret;
+    pthread_mutex_t mutex;
+} setapa;
+
+// Llegeix l'objectiu "mitjana:T", "p95:T" o "T" (mitjana). Retorna 0 si va be.
+int llegeix_objectiu(const char *s, int *mesura, double *valor){
+    const char *v = strchr(s, ':');
+    char *fi;
+
+    if (v == NULL){
+        *mesura = OPT_MITJANA;
+        v = s;
+    }else{
+        if (!strncmp(s, "mitjana:", v - s + 1))
+            *mesura = OPT_MITJANA;
+        else if (!strncmp(s, "p95:", v - s + 1))
+            *mesura = OPT_P95;
+        else
+            return (-1);
+        v++;
+    }
+    *valor = strtod(v, &fi);
+    return ((fi == v || *fi != '\0' || !(*valor > 0)) ? -1 : 0);
+} // llegeix_objectiu
+
+// Mesura d'una replicacio: temps de cua mitja de tots els clients o
+// percentil 95 (els que no fan cua compten amb temps 0)
+static double mesura_replica(sstats *s, int ntc, int mesura){
+    shdr q;
+    long n = 0;
+    double suma = 0, v = 0;
+    int c;
+
+    for (c = 0; c < ntc; c++){
+        n += s->dshist[c].samples;
+        suma += s->dqhist[c].sum;
+    }
+    if (n == 0)
+        return (0.0);
+    if (mesura == OPT_MITJANA)
+        return (suma / n);
+    init_hdr(&q, HDRBITS);
+    for (c = 0; c < ntc; c++)
+        suma_hdr(&q, &s->dqhist[c]);
+    if (q.samples > 0.05 * n)   // el percentil cau entre els que han fet cua
+        v = percentile_hdr(&q, 100.0 * (q.samples - 0.05 * n) / q.samples);
+    free_hdr(&q);
+    return (v);
+} // mesura_replica
+
+// Fil de treball: agafa treballs pendents de l'etapa fins que no en queden
+static void *treballador(void *arg){
+    setapa *e = (setapa *) arg;
+    scandidat *c;
+    sstats s;
+    int k, ret;
+
+    for (;;){
+        pthread_mutex_lock(&e->mutex);
+        k = e->seguent++;
+        pthread_mutex_unlock(&e->mutex);
+        if (k >= e->nfeina)
+            break;
+
+        c = &e->c[e->cand[k]];
+        n_rapids = c->rapids;
+        fraccio_rapids = c->fraccio;
+        ini_alea(e->llavor, e->rep[k]);   // numeros aleatoris comuns
+        init_stats(&s, c->ntc);
+        if (escalfament)
+            ini_mser(&s);
+        ret = simula(c->ntc, &s);
+        c->y[e->rep[k]] = mesura_replica(&s, c->ntc, e->mesura);
+        free_stats(s, c->ntc);
+        if (ret != 0){
+            pthread_mutex_lock(&e->mutex);
+            e->ret = ret;
+            pthread_mutex_unlock(&e->mutex);
+        }
+    }
+    allibera_traca();
+    allibera_alea();
+    return (NULL);
+} // treballador
+
+// Porta les candidates vives fins a r replicacions, en paral·lel
+static int executa_etapa(scandidat *c, int nc, int r, int nfils, int mesura, long int llavor){
+    setapa e;
+    pthread_t *fils;
+    int i, k, f;
+
+    e.c = c;
+    e.cand = (int *) malloc(nc * r * sizeof(int));
+    e.rep = (int *) malloc(nc * r * sizeof(int));
+    if (e.cand == NULL || e.rep == NULL)
+        ERROR((ofile, "ERROR: allocating memory in executa_etapa\n"));
+    e.nfeina = 0;
+    for (i = 0; i < nc; i++)
+        if (c[i].estat == OPT_VIVA)
+            for (k = c[i].r; k < r; k++){
+                e.cand[e.nfeina] = i;
+                e.rep[e.nfeina++] = k;
+            }
+    e.seguent = 0;
+    e.mesura = mesura;
+    e.llavor = (unsigned long long) llavor;
+    e.ret = 0;
+    pthread_mutex_init(&e.mutex, NULL);
+
+    if (nfils > e.nfeina) nfils = e.nfeina;
+    fils = (pthread_t *) malloc(nfils * sizeof(pthread_t));
+    if (fils == NULL)
+        ERROR((ofile, "ERROR: allocating memory in executa_etapa\n"));
+    for (f = 0; f < nfils; f++)
+        if (pthread_create(&fils[f], NULL, treballador, &e) != 0)
+            ERROR((ofile, "ERROR: creating thread %d in executa_etapa\n", f));
+    for (f = 0; f < nfils; f++)
+        pthread_join(fils[f], NULL);
+
+    for (i = 0; i < nc; i++)
+        if (c[i].estat == OPT_VIVA)
+            c[i].r = r;
+    pthread_mutex_destroy(&e.mutex);
+    free(fils);
+    free(e.cand);
+    free(e.rep);
+    return (e.ret);
+} // executa_etapa
+
+// Variancia de la diferencia de les primeres n observacions de a i b
+static double variancia_diferencia(const double *a, const double *b, int n){
+    double m = 0, s = 0, d;
+    int k;
+
+    for (k = 0; k < n; k++)
+        m += a[k] - b[k];
+    m /= n;
+    for (k = 0; k < n; k++){
+        d = a[k] - b[k] - m;
+        s += d * d;
+    }
+    return (s / (n - 1));
+} // variancia_diferencia
+
+// Avalua les nc configuracions d'un nivell de personal. Retorna la triada
+// (la de menys temps de cua que compleix l'objectiu) o NA si cap el compleix.
+static int avalua_nivell(scandidat *c, int nc, int nfils, int mesura, double objectiu,
+                         long int llavor, long *total){
+    double *s2, h2 = 0, delta = OPTDELTA * objectiu, w;
+    int *viva;
+    int i, l, r, nvives, pendents, tria = NA;
+
+    s2 = (double *) malloc(nc * nc * sizeof(double));
+    viva = (int *) malloc(nc * sizeof(int));
+    if (s2 == NULL || viva == NULL)
+        ERROR((ofile, "ERROR: allocating memory in avalua_nivell\n"));
+    // Constant de Kim-Nelson (no la de Rinott): h2 = 2 eta (n0 - 1), amb
+    // eta = ((2 alfa / (nc - 1))^(-2 / (n0 - 1)) - 1) / 2
+    if (nc > 1)
+        h2 = (pow(2 * STSALPHA / (nc - 1), -2.0 / (OPTN0 - 1)) - 1) * (OPTN0 - 1);
+
+    r = OPTN0;
+    for (;;){
+        if (executa_etapa(c, nc, r, nfils, mesura, llavor) != 0)
+            ERROR((ofile, "ERROR: una replicacio de l'optimitzador no ha acabat be\n"));
+        if (r == OPTN0)
+            for (i = 0; i < nc; i++)
+                for (l = 0; l < nc; l++)
+                    s2[i * nc + l] = (i == l) ? 0 : variancia_diferencia(c[i].y, c[l].y, OPTN0);
+
+        // Factibilitat: interval unilateral al nivell 1 - STSALPHA
+        for (i = 0; i < nc; i++){
+            if (c[i].estat != OPT_VIVA)
+                continue;
+            c[i].ic = compute_confidence_interval_t(c[i].y, r, 2 * STSALPHA, &c[i].mitjana);
+            if (c[i].mitjana - c[i].ic > objectiu)
+                c[i].estat = OPT_INFACTIBLE;
+            else if (c[i].mitjana + c[i].ic <= objectiu)
+                c[i].factible = 1;
+        }
+
+        // KN: es descarta i si la seva mitjana supera la d'una altra viva
+        // en mes del marge W que permet la variancia de la diferencia
+        for (i = 0; i < nc; i++)
+            viva[i] = (c[i].estat == OPT_VIVA);
+        for (i = 0; i < nc; i++)
+            for (l = 0; viva[i] && l < nc; l++){
+                if (l == i || !viva[l])
+                    continue;
+                w = delta / (2.0 * r) * (h2 * s2[i * nc + l] / (delta * delta) - r);
+                if (w < 0) w = 0;
+                if (c[i].mitjana > c[l].mitjana + w)
+                    c[i].estat = OPT_DESCARTADA;
+            }
+
+        nvives = pendents = 0;
+        for (i = 0; i < nc; i++)
+            if (c[i].estat == OPT_VIVA){
+                nvives++;
+                pendents += !c[i].factible;
+            }
+        if (nvives == 0 || (nvives == 1 && pendents == 0) || r >= OPTMAXREP)
+            break;
+        // Prou replicacions per ocupar els fils a la seguent etapa
+        r += (nfils + nvives - 1) / nvives;
+        if (r > OPTMAXREP) r = OPTMAXREP;
+    }
+
+    // Entre les vives que compleixen l'objectiu (o, al maxim de
+    // replicacions, que el compleixen en mitjana) la de menys temps de cua
+    for (i = 0; i < nc; i++){
+        *total += c[i].r;
+        if (c[i].estat == OPT_VIVA && (c[i].factible || c[i].mitjana <= objectiu)
+                && (tria == NA || c[i].mitjana < c[tria].mitjana))
+            tria = i;
+    }
+    free(s2);
+    free(viva);
+    return (tria);
+} // avalua_nivell
+
+// Busca la configuracio de menys caixers (fins a nmax) que compleix
+// l'objectiu i escriu el resultat a ofile. Retorna 0 si en troba una.
+int optimitza(int nmax, int nfils, long int llavor, int mesura, double objectiu){
+    scandidat *c;
+    int nfrac, nc, ntc, k, f, i, tria = NA;
+    long total = 0, total_nivell;
+
+    if (nfils <= 0) nfils = nombre_nuclis();
+    nfrac = (int) ((OPTFRACMAX - OPTFRACMIN) / OPTFRACPAS + 1.5);
+    c = (scandidat *) malloc((nmax > 1 ? nmax - 1 : 1) * nfrac * sizeof(scandidat));
+    if (c == NULL)
+        ERROR((ofile, "ERROR: allocating memory in optimitza\n"));
+
+    fprintf(ofile,"\n");
+    MESSAGE((ofile, "-----------------------------------------------------------\n"));
+    MESSAGE((ofile, "----- Optimitzador de personal ----------------------------\n"));
+    MESSAGE((ofile, "-----------------------------------------------------------\n"));
+    fprintf(ofile,"Objectiu: %s del temps de cua <= %g (zona d'indiferencia %g)\n",
+            mesura == OPT_MITJANA ? "mitjana" : "percentil 95", objectiu, OPTDELTA * objectiu);
+    fprintf(ofile,"Replicacions: %d inicials, %d maximes, alfa %g, Fils: %d, Llavor: %ld\n\n",
+            OPTN0, OPTMAXREP, STSALPHA, nfils, llavor);
+
+    for (ntc = 2; ntc <= nmax && tria == NA; ntc++){
+        nc = 0;
+        for (k = 1; k < ntc; k++)
+            for (f = 0; f < nfrac; f++){
+                memset(&c[nc], 0, sizeof(scandidat));
+                c[nc].ntc = ntc;
+                c[nc].rapids = k;
+                c[nc].fraccio = OPTFRACMIN + f * OPTFRACPAS;
+                c[nc].estat = OPT_VIVA;
+                nc++;
+            }
+        total_nivell = 0;
+        i = avalua_nivell(c, nc, nfils, mesura, objectiu, llavor, &total_nivell);
+        total += total_nivell;
+
+        fprintf(ofile,"Caixers %d: %d configuracions, %ld replicacions\n", ntc, nc, total_nivell);
+        fprintf(ofile,"  Rapids Fraccio  Rep.    Mesura        IC  Estat\n");
+        for (k = 0; k < nc; k++)
+            fprintf(ofile,"  %6d %7.2lf %5d %9.3lf %9.3lf  %s%s\n", c[k].rapids, c[k].fraccio, c[k].r,
+                    c[k].mitjana, c[k].ic, nom_estat[c[k].estat],
+                    k == i ? " <- triada" : (c[k].estat == OPT_VIVA && c[k].factible) ? " (compleix)" : "");
+        fprintf(ofile,"\n");
+        if (i != NA){
+            tria = i;
+            fprintf(ofile,"Configuracio triada: %d caixers, %d rapids, fraccio de clients rapids %.2lf\n",
+                    c[i].ntc, c[i].rapids, c[i].fraccio);
+            fprintf(ofile,"  %s del temps de cua %.3lf (+%.3lf al %.0lf%%, %d replicacions)\n",
+                    mesura == OPT_MITJANA ? "Mitjana" : "Percentil 95", c[i].mitjana, c[i].ic,
+                    100 * (1 - STSALPHA), c[i].r);
+        }
+    }
+    if (tria == NA)
+        fprintf(ofile,"Cap configuracio amb fins a %d caixers compleix l'objectiu\n", nmax);
+    fprintf(ofile,"Replicacions totals: %ld\n\n", total);
+    free(c);
+    return (tria == NA ? -1 : 0);
+} // optimitza
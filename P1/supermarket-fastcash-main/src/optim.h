@@ -0,0 +1,27 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Declaracions de l'optimitzador de personal (-z objectiu)
+ *
+ * File:   optim.h
+ * Author: Dolors Sala
+ */
+
+#ifndef OPTIM_H
+#define	OPTIM_H
+
+#define OPT_MITJANA   0      // objectiu sobre el temps de cua mitja de tots els clients
+#define OPT_P95       1      // objectiu sobre el percentil 95 del temps de cua
+
+#define OPTN0         10     // replicacions inicials de cada configuracio
+#define OPTMAXREP     200    // replicacions maximes de cada configuracio
+#define OPTDELTA      0.10   // zona d'indiferencia, fraccio de l'objectiu
+#define OPTFRACMIN    0.10   // fraccions de clients rapids que es proven
+#define OPTFRACMAX    0.50
+#define OPTFRACPAS    0.10
+
+int llegeix_objectiu(const char *s, int *mesura, double *valor);
+int optimitza(int nmax, int nfils, long int llavor, int mesura, double objectiu);
+
+#endif	/* OPTIM_H */
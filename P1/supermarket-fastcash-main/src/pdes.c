@@ -0,0 +1,448 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Motor paral·lel conservador (PDES) per supermercats amb molts caixers.
+ *
+ * Els caixers es reparteixen en nlps processos logics (LP), cadascun amb el
+ * seu fil, la seva agenda i les seves cues. Les arribades les genera un
+ * distribuidor (el fil principal) que tria el caixer amb la politica
+ * d'encaminament (tria_cua) sobre una copia de les cues i envia el client al LP
+ * corresponent com un missatge.
+ *
+ * La sincronitzacio es per finestres (YAWNS): si T es el proper event de
+ * tot el sistema, cap event de [T, T + LOOKAHEAD) pot programar una sortida
+ * dins la mateixa finestra, perque un servei dura com a minim LOOKAHEAD.
+ * Per tant les sortides de la finestra ja son a les agendes dels LPs i el
+ * distribuidor pot encaminar totes les arribades de la finestra abans que
+ * els LPs la processin en paral·lel.
+ *
+ * Els resultats son identics als del motor sequencial (simula) amb la mateixa
+ * llavor: el generador nomes el fa servir el distribuidor, en el mateix ordre,
+ * i els empats de temps entre una arribada i una sortida es resolen com a
+ * l'agenda sequencial (primer el que es va programar abans).
+ *
+ * File:   pdes.c
+ * Author: Dolors Sala
+ */
+
+#include <pthread.h>
+#include <time.h>
+#include "sev.h"
+#include "cua.h"
+#include "agenda.h"
+#include "stats.h"
+#include "pdes.h"
+#include "perfil.h"
+
+#define INFINIT    HUGE_VALF   // Cap event pendent
+
+// Client que el distribuidor envia a un LP
+typedef struct {
+    float tar;    // temps d'arribada
+    float tse;    // temps de servei (es decideix en arribar)
+    float tpos;   // quan es va programar l'arribada (l'arribada anterior)
+    int on;       // caixer triat
+} mclient;
+
+// Sortida pendent d'un caixer dins la finestra
+typedef struct {
+    float quan;   // temps de la sortida
+    float tpos;   // quan es va programar (inici del servei)
+    int on;       // caixer
+} msortida;
+
+typedef struct spdes spdes;
+
+// Proces logic: un bloc de caixers consecutius amb la seva agenda i cues
+typedef struct {
+    spdes *p;             // estat compartit
+    int ini, fin;         // caixers [ini, fin]
+    scua *cues;           // cues dels caixers (index c - ini)
+    mclient *bustia;      // clients rebuts per la finestra actual
+    int nbustia;
+    int maxbustia;
+    float tmin;           // proper event pendent (INFINIT si no n'hi ha)
+    float tult;           // ultim event processat
+    long nev;             // events processats
+    pthread_t fil;
+} slp;
+
+// Barrera reutilitzable (pthread_barrier_t no existeix a tots els sistemes)
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int n;                // fils que s'han d'esperar
+    int esperant;
+    unsigned long torn;
+} sbarrera;
+
+// Estat compartit entre el distribuidor i els LPs
+struct spdes {
+    int ntc;
+    int nlps;
+    slp *lps;
+    int *lpde;            // lpde[c]: LP del caixer c
+    float *sortida;       // sortida[c]: sortida pendent del caixer c (INFINIT si lliure)
+    float *tpos;          // tpos[c]: quan es va programar la sortida pendent
+    float fi_finestra;    // la finestra actual es [T, fi_finestra)
+    float tfinal;         // ultim temps amb estadistiques, per tancar-les
+    int acabat;
+    sstats *sts;
+    sbarrera barrera;
+};
+
+static void ini_barrera(sbarrera *b, int n){
+    pthread_mutex_init(&b->mutex, NULL);
+    pthread_cond_init(&b->cond, NULL);
+    b->n = n;
+    b->esperant = 0;
+    b->torn = 0;
+} // ini_barrera
+
+static void espera_barrera(sbarrera *b){
+    unsigned long torn;
+
+    pthread_mutex_lock(&b->mutex);
+    torn = b->torn;
+    if(++b->esperant == b->n){
+        b->esperant = 0;
+        b->torn++;
+        pthread_cond_broadcast(&b->cond);
+    }else{
+        while(torn == b->torn)
+            pthread_cond_wait(&b->cond, &b->mutex);
+    }
+    pthread_mutex_unlock(&b->mutex);
+} // espera_barrera
+
+static void elim_barrera(sbarrera *b){
+    pthread_mutex_destroy(&b->mutex);
+    pthread_cond_destroy(&b->cond);
+} // elim_barrera
+
+// Cert si la sortida (quan, tpos) surt abans que l'arribada m a l'agenda
+// sequencial: la de menys temps i, si empaten, la que es va programar abans.
+// Si tambe es van programar al mateix temps, la sortida la va posar
+// l'arribada anterior just abans de programar la seguent arribada.
+static int sortida_abans(float quan, float tpos, mclient *m){
+    if(quan != m->tar)
+        return(quan < m->tar);
+    if(tpos != m->tpos)
+        return(tpos < m->tpos);
+    return(1);
+} // sortida_abans
+
+static int compara_sortides(const void *a, const void *b){
+    const msortida *x = (const msortida *) a;
+    const msortida *y = (const msortida *) b;
+
+    if(x->quan != y->quan)
+        return(x->quan < y->quan ? -1 : 1);
+    return(x->on - y->on);
+} // compara_sortides
+
+//--------------------------- Processos logics ---------------------------
+
+// Un client arriba al caixer m->on del LP
+static void arriba_lp(spdes *p, slp *lp, mclient *m){
+    int i = m->on - lp->ini;
+    scua *cua = &lp->cues[i];
+    float ta = m->tar;
+    el_cua c;
+    esdev e;
+
+    if(cua->caixa == 0){
+        posa_caixa(cua, 1);
+        inc_servei(p->sts, m->on, ta, 0, m->tse, 0);
+        TRACA(TRACAserv, ta, 'S', ARRIBADA, m->on, 0, m->tse);
+        e = crea_esdev(SORTIDA, ta+m->tse, m->on);
+        posa_agenda(ta, e);
+        p->sortida[m->on] = e.quan;
+        p->tpos[m->on] = ta;
+    }else{
+        c.tar = ta;
+        c.tse = m->tse;
+        c.on = m->on;
+        actualitzar_stats_caixer(cua, m->on, ta, p->sts);
+        posa_cua(cua, ta, c);
+    }
+    lp->tult = ta;
+    lp->nev++;
+} // arriba_lp
+
+// El caixer e->on del LP acaba un servei i comença el seguent client de la cua
+static void surt_lp(spdes *p, slp *lp, esdev *e){
+    int i = e->on - lp->ini;
+    scua *cua = &lp->cues[i];
+    float ta = e->quan;
+    float t;
+    el_cua c;
+    esdev s;
+
+    inc_atesos(p->sts, e->on, ta);
+    if(cua->lon_cua > 0)
+        actualitzar_stats_caixer(cua, e->on, ta, p->sts);
+    if(treu_cua(cua, ta, &c) != 0){
+        t = e->quan - c.tar;
+        inc_servei(p->sts, e->on, ta, t, c.tse, 1);
+        TRACA(TRACAserv, ta, 'E', SORTIDA, e->on, cua->lon_cua, t);
+        t = c.tse;
+        TRACA(TRACAserv, ta, 'S', SORTIDA, e->on, cua->lon_cua, t);
+        s = crea_esdev(SORTIDA, ta+t, e->on);
+        posa_agenda(ta, s);
+        p->sortida[e->on] = s.quan;
+        p->tpos[e->on] = ta;
+    }else{
+        posa_caixa(cua, 0);
+        p->sortida[e->on] = INFINIT;
+    }
+    lp->tult = ta;
+    lp->nev++;
+} // surt_lp
+
+// Processa en ordre els clients rebuts i les sortides de l'agenda del LP
+// dins la finestra actual
+static void finestra_lp(spdes *p, slp *lp){
+    esdev e;
+    int k = 0;
+    int sortida;
+
+    for(;;){
+        sortida = primer_agenda(&e) && e.quan < p->fi_finestra;
+        if(k < lp->nbustia &&
+           (!sortida || !sortida_abans(e.quan, p->tpos[e.on], &lp->bustia[k]))){
+            arriba_lp(p, lp, &lp->bustia[k++]);
+        }else if(sortida){
+            treu_agenda(e.quan, &e);
+            surt_lp(p, lp, &e);
+        }else
+            break;
+    }
+    lp->nbustia = 0;
+    lp->tmin = primer_agenda(&e) ? e.quan : INFINIT;
+} // finestra_lp
+
+// Fil d'un LP: processa finestres fins que el distribuidor indica que s'ha acabat
+static void *fil_lp(void *arg){
+    slp *lp = (slp *) arg;
+    spdes *p = lp->p;
+    int i, n = lp->fin - lp->ini + 1;
+
+    ini_agenda(N);
+    crea_cues(&lp->cues, CUA_MAX, n);
+    for(i = 0; i < n; i++)
+        lp->cues[i].idcua = lp->ini + i;
+
+    for(;;){
+        espera_barrera(&p->barrera);    // el distribuidor ha omplert les busties
+        if(p->acabat)
+            break;
+        finestra_lp(p, lp);
+        espera_barrera(&p->barrera);    // finestra processada
+    }
+    // Tanca l'estadistica de cada cua a l'ultim event del sistema
+    for(i = 0; i < n; i++)
+        actualitzar_stats_caixer(&lp->cues[i], lp->ini + i, p->tfinal, p->sts);
+    elim_cues(lp->cues, n);
+    allibera_agenda();
+    allibera_traca();
+    return(NULL);
+} // fil_lp
+
+//----------------------------- Distribuidor -----------------------------
+
+// Tria el caixer del client m amb la copia de les cues del distribuidor i
+// li dona el temps de servei del flux del caixer triat
+static int tria_caixer(scua *ombra, int ntc, int esRapid, mclient *m){
+    int on;
+    int ini = esRapid ? 0 : n_rapids;
+    int fin = esRapid ? n_rapids - 1 : ntc - 1;
+    el_cua c;
+
+    on = tria_cua(ombra, ini, fin, m->tar);
+    m->tse = temps_servei(on);
+    TRACA(TRACAalea, m->tar, 'S', ARRIBADA, on, 0, m->tse);
+    if(ombra[on].caixa == 0){
+        TRACA(TRACAquinaCua, m->tar, 'B', ARRIBADA, on, 0, esRapid);
+        posa_caixa(&ombra[on], 1);
+        ombra[on].fi_servei = m->tar + m->tse;
+        return(on);
+    }
+    TRACA(TRACAquinaCua, m->tar, 'C', ARRIBADA, on, ombra[on].lon_cua, esRapid);
+    c.tar = m->tar;
+    c.tse = m->tse;
+    c.on = on;
+    posa_cua(&ombra[on], m->tar, c);
+    return(on);
+} // tria_caixer
+
+// Aplica una sortida a la copia de les cues del distribuidor
+static void aplica_sortida(scua *ombra, msortida *s){
+    el_cua c;
+
+    if(treu_cua(&ombra[s->on], s->quan, &c) == 0)
+        posa_caixa(&ombra[s->on], 0);
+} // aplica_sortida
+
+// Envia el client m a la bustia del LP
+static void envia(slp *lp, mclient *m){
+    if(lp->nbustia == lp->maxbustia){
+        lp->maxbustia = (lp->maxbustia == 0) ? N : 2 * lp->maxbustia;
+        lp->bustia = (mclient *) realloc(lp->bustia, lp->maxbustia * sizeof(mclient));
+        if(lp->bustia == NULL)
+            ERROR((ofile, "ERROR: allocating memory in envia\n"));
+    }
+    lp->bustia[lp->nbustia++] = *m;
+} // envia
+
+static double segons(void){
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return(ts.tv_sec + ts.tv_nsec * 1e-9);
+} // segons
+
+// Executa una replicacio de la simulacio amb ntc caixers repartits en nlps
+// processos logics. Acumula les estadistiques a sts (ja inicialitzat) i
+// escriu a ofile el rendiment del motor. Retorna 0 si acaba be.
+int simula_pdes(int ntc, int nlps, sstats *sts){
+    spdes p;
+    scua *ombra = NULL;   // copia de les cues que fa servir el distribuidor
+    msortida *sort;       // sortides de la finestra
+    mclient m;
+    slp *lp;
+    int ns, i, l, c, obert, esRapid;
+    float T, ta = 0;
+    float arribada, tpos_arr;
+    long nfinestres = 0, nev = 0;
+    double t0, t1;
+
+    if(nlps > ntc) nlps = ntc;
+    if(nlps < 1) nlps = 1;
+
+    p.ntc = ntc;
+    p.nlps = nlps;
+    p.sts = sts;
+    p.acabat = 0;
+    p.lps = (slp *) calloc(nlps, sizeof(slp));
+    p.lpde = (int *) malloc(ntc * sizeof(int));
+    p.sortida = (float *) malloc(ntc * sizeof(float));
+    p.tpos = (float *) calloc(ntc, sizeof(float));
+    sort = (msortida *) malloc(ntc * sizeof(msortida));
+    if(p.lps == NULL || p.lpde == NULL || p.sortida == NULL || p.tpos == NULL ||
+       sort == NULL)
+        ERROR((ofile, "ERROR: allocating memory in simula_pdes\n"));
+    for(c = 0; c < ntc; c++)
+        p.sortida[c] = INFINIT;
+    crea_cues(&ombra, CUA_MAX, ntc);
+    for(l = 0; l < nlps; l++){
+        lp = &p.lps[l];
+        lp->p = &p;
+        lp->ini = (int)((long) l * ntc / nlps);
+        lp->fin = (int)((long)(l + 1) * ntc / nlps) - 1;
+        lp->tmin = INFINIT;
+        for(c = lp->ini; c <= lp->fin; c++)
+            p.lpde[c] = l;
+    }
+    ini_barrera(&p.barrera, nlps + 1);
+
+    t0 = segons();
+    for(l = 0; l < nlps; l++)
+        if(pthread_create(&p.lps[l].fil, NULL, fil_lp, &p.lps[l]) != 0)
+            ERROR((ofile, "ERROR: creating thread %d in simula_pdes\n", l));
+
+    // Obrir: primera arribada, com el motor sequencial
+    tpos_arr = OBRIRTIME;
+    arribada = seguent_arribada(OBRIRTIME);
+    TRACA(TRACAalea, OBRIRTIME, 'A', ARRIBADA, NA, 0, arribada);
+    obert = (arribada < TANCARTIME);
+
+    for(;;){
+        T = obert ? arribada : INFINIT;
+        for(l = 0; l < nlps; l++)
+            if(p.lps[l].tmin < T)
+                T = p.lps[l].tmin;
+        if(T == INFINIT)
+            break;
+        p.fi_finestra = (float)(T + LOOKAHEAD);
+        nfinestres++;
+
+        // Sortides de la finestra (ja programades, un servei dura >= LOOKAHEAD)
+        ns = 0;
+        for(l = 0; l < nlps; l++){
+            lp = &p.lps[l];
+            if(lp->tmin < p.fi_finestra)
+                for(c = lp->ini; c <= lp->fin; c++)
+                    if(p.sortida[c] < p.fi_finestra){
+                        sort[ns].quan = p.sortida[c];
+                        sort[ns].tpos = p.tpos[c];
+                        sort[ns].on = c;
+                        ns++;
+                    }
+        }
+        qsort(sort, ns, sizeof(msortida), compara_sortides);
+
+        // Encamina les arribades de la finestra
+        i = 0;
+        while(obert && arribada < p.fi_finestra){
+            m.tar = arribada;
+            m.tpos = tpos_arr;
+            while(i < ns && sortida_abans(sort[i].quan, sort[i].tpos, &m))
+                aplica_sortida(ombra, &sort[i++]);
+            ta = arribada;
+            esRapid = (alea(ALEA_CLASSE) < fraccio_rapids) ? 1 : 0;
+            m.on = tria_caixer(ombra, ntc, esRapid, &m);
+            envia(&p.lps[p.lpde[m.on]], &m);
+
+            // Decidir la seguent arribada
+            tpos_arr = ta;
+            arribada = seguent_arribada(ta);
+            TRACA(TRACAalea, ta, 'A', ARRIBADA, NA, 0, arribada - ta);
+            if(arribada >= TANCARTIME)
+                obert = 0;
+        }
+        while(i < ns)
+            aplica_sortida(ombra, &sort[i++]);
+
+        espera_barrera(&p.barrera);     // els LPs processen la finestra
+        espera_barrera(&p.barrera);
+    }
+
+    // Final: els LPs tanquen les estadistiques de les cues i acaben
+    p.tfinal = ta;
+    for(l = 0; l < nlps; l++){
+        if(p.lps[l].tult > p.tfinal)
+            p.tfinal = p.lps[l].tult;
+        nev += p.lps[l].nev;
+    }
+    p.acabat = 1;
+    espera_barrera(&p.barrera);
+    for(l = 0; l < nlps; l++)
+        pthread_join(p.lps[l].fil, NULL);
+    t1 = segons();
+
+    fprintf(ofile,"\n");
+    MESSAGE((ofile, "-----------------------------------------------------------\n"));
+    MESSAGE((ofile, "----- Motor paral·lel conservador (finestres YAWNS) -------\n"));
+    MESSAGE((ofile, "-----------------------------------------------------------\n"));
+    fprintf(ofile,"Processos logics (LPs)     : %d\n", nlps);
+    fprintf(ofile,"Lookahead                  : %.1lf\n", LOOKAHEAD);
+    fprintf(ofile,"Finestres                  : %ld\n", nfinestres);
+    fprintf(ofile,"Events processats          : %ld\n", nev);
+    fprintf(ofile,"Temps real (s)             : %.6lf\n", t1 - t0);
+    fprintf(ofile,"Events per segon           : %.0lf\n", (t1 > t0) ? nev / (t1 - t0) : 0.0);
+    fprintf(ofile,"\n");
+
+    elim_barrera(&p.barrera);
+    for(l = 0; l < nlps; l++){
+        free(p.lps[l].bustia);
+    }
+    free(p.lps);
+    free(p.lpde);
+    free(p.sortida);
+    free(p.tpos);
+    elim_cues(ombra, ntc);
+    free(sort);
+    return(0);
+} // simula_pdes
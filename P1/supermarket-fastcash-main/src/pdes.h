@@ -0,0 +1,20 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Declaracions del motor paral·lel conservador (processos logics)
+ *
+ * File:   pdes.h
+ * Author: Dolors Sala
+ */
+
+#ifndef PDES_H
+#define	PDES_H
+
+#include "stats.h"
+
+#define LOOKAHEAD   1.0   // Temps minim de servei (1 + expo(SERVICE)): lookahead dels LPs
+
+int simula_pdes(int ntc, int nlps, sstats *sts);
+
+#endif	/* PDES_H */
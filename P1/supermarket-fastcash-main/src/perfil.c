@@ -0,0 +1,212 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Arribades de Poisson no homogenies amb un perfil de taxa (-l fitxer,
+ * veure perfil.h).
+ *
+ * La seguent arribada s'obte invertint la intensitat acumulada
+ * L(t) = integral de la taxa fins a t: si el client anterior ha arribat a
+ * ta, el seguent arriba a L^-1(L(ta) + E), amb E exponencial de mitjana 1.
+ * Cada arribada costa un sol valor aleatori (no hi ha rebutjos com amb el
+ * metode d'aprimament) i dues cerques binaries entre els punts del perfil,
+ * sigui quina sigui la diferencia entre la taxa de punta i la de vall. El
+ * resultat nomes depen de ta, de manera que els punts de control i les
+ * replicacions no han de desar cap estat.
+ *
+ * File:   perfil.c
+ * Author: Dolors Sala
+ */
+
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <float.h>
+#include "sev.h"
+#include "perfil.h"
+
+#define PERFLINIA    256        // longitud maxima d'una linia del perfil
+
+static double *perf_t = NULL;   // temps dels punts (creixents)
+static double *perf_r = NULL;   // taxa a cada punt
+static double *perf_l = NULL;   // intensitat acumulada a cada punt (0 al primer)
+static int perf_n = 0;          // punts del perfil (0: arribades homogenies)
+static int perf_tipus = PERFIL_ESGLAO;
+
+// Llegeix el camp numeric que comença a *s i passa el separador que el
+// segueix. Retorna 0 si no hi ha cap numero.
+static int llegeix_valor(char **s, double *v){
+    char *fi;
+
+    *v = strtod(*s, &fi);
+    if (fi == *s)
+        return (0);
+    while (*fi == ' ' || *fi == '\t' || *fi == ',' || *fi == ';')
+        fi++;
+    *s = fi;
+    return (1);
+} // llegeix_valor
+
+// Afegeix el punt (t, r) al perfil. Retorna 0 si va be.
+static int afegeix_punt(double t, double r, int *capacitat){
+    double *v;
+
+    if (perf_n == *capacitat){
+        *capacitat = (*capacitat > 0) ? 2 * *capacitat : 32;
+        if ((v = (double *) realloc(perf_t, *capacitat * sizeof(double))) == NULL)
+            return (-1);
+        perf_t = v;
+        if ((v = (double *) realloc(perf_r, *capacitat * sizeof(double))) == NULL)
+            return (-1);
+        perf_r = v;
+        if ((v = (double *) realloc(perf_l, *capacitat * sizeof(double))) == NULL)
+            return (-1);
+        perf_l = v;
+    }
+    perf_t[perf_n] = t;
+    perf_r[perf_n] = r;
+    perf_n++;
+    return (0);
+} // afegeix_punt
+
+// Llegeix el perfil del fitxer nom i calcula la intensitat acumulada a cada
+// punt. Retorna 0 si va be.
+int llegeix_perfil(const char *nom){
+    FILE *f;
+    char linia[PERFLINIA], *s;
+    double t, r;
+    int i, capacitat = 0, nlinia = 0, ok = 1;
+
+    if ((f = fopen(nom, "r")) == NULL)
+        return (-1);
+    while (ok && fgets(linia, sizeof(linia), f) != NULL){
+        nlinia++;
+        for (s = linia; isspace((unsigned char) *s); s++)
+            ;
+        if (*s == '\0' || *s == '#')
+            continue;
+        if (isalpha((unsigned char) *s)){
+            if (!strncmp(s, "lineal", 6))
+                perf_tipus = PERFIL_LINEAL;
+            else if (!strncmp(s, "esglao", 6))
+                perf_tipus = PERFIL_ESGLAO;
+            else{
+                fprintf(stderr, "ERROR perfil: linia %d de %s desconeguda\n", nlinia, nom);
+                ok = 0;
+            }
+            continue;
+        }
+        if (!llegeix_valor(&s, &t) || !llegeix_valor(&s, &r) || r < 0){
+            fprintf(stderr, "ERROR perfil: linia %d de %s sense temps i taxa (>= 0)\n", nlinia, nom);
+            ok = 0;
+        }else if (perf_n > 0 && t <= perf_t[perf_n - 1]){
+            fprintf(stderr, "ERROR perfil: linia %d de %s fora d'ordre (%g <= %g)\n",
+                    nlinia, nom, t, perf_t[perf_n - 1]);
+            ok = 0;
+        }else if (afegeix_punt(t, r, &capacitat) != 0){
+            fprintf(stderr, "ERROR perfil: no hi ha prou memoria\n");
+            ok = 0;
+        }
+    }
+    fclose(f);
+    if (ok && perf_n == 0){
+        fprintf(stderr, "ERROR perfil: %s no te cap punt\n", nom);
+        ok = 0;
+    }
+    if (!ok){
+        allibera_perfil();
+        return (-1);
+    }
+    perf_l[0] = 0;
+    for (i = 0; i + 1 < perf_n; i++)
+        perf_l[i + 1] = perf_l[i] + (perf_t[i + 1] - perf_t[i])
+                        * ((perf_tipus == PERFIL_LINEAL) ? (perf_r[i] + perf_r[i + 1]) / 2 : perf_r[i]);
+    return (0);
+} // llegeix_perfil
+
+// Allibera el perfil (no fa res si no n'hi ha)
+void allibera_perfil(void){
+    free(perf_t);
+    free(perf_r);
+    free(perf_l);
+    perf_t = perf_r = perf_l = NULL;
+    perf_n = 0;
+    perf_tipus = PERFIL_ESGLAO;
+} // allibera_perfil
+
+// 1 si les arribades segueixen un perfil de taxa
+int hi_ha_perfil(void){
+    return (perf_n > 0);
+} // hi_ha_perfil
+
+// Darrer punt i amb v[i] <= x (0 si no n'hi ha cap)
+static int cerca_punt(const double *v, double x){
+    int a = 0, b = perf_n - 1, m;
+
+    while (a < b){
+        m = (a + b + 1) / 2;
+        if (v[m] <= x)
+            a = m;
+        else
+            b = m - 1;
+    }
+    return (a);
+} // cerca_punt
+
+// Pendent de la taxa al tram que comença al punt i
+static double pendent(int i){
+    if (perf_tipus == PERFIL_ESGLAO || i + 1 >= perf_n)
+        return (0);
+    return ((perf_r[i + 1] - perf_r[i]) / (perf_t[i + 1] - perf_t[i]));
+} // pendent
+
+// Intensitat acumulada L(t)
+static double intensitat(double t){
+    int i;
+    double s;
+
+    if (t <= perf_t[0])
+        return (perf_r[0] * (t - perf_t[0]));
+    i = cerca_punt(perf_t, t);
+    s = t - perf_t[i];
+    return (perf_l[i] + s * (perf_r[i] + pendent(i) * s / 2));
+} // intensitat
+
+// Inversa de la intensitat acumulada: primer t amb L(t) = x (DBL_MAX si la
+// taxa ja no torna a ser positiva)
+static double inversa(double x){
+    int i;
+    double d, a, b, s;
+
+    if (x < 0)     // abans del primer punt (nomes si la seva taxa es positiva)
+        return (perf_t[0] + x / perf_r[0]);
+    i = cerca_punt(perf_l, x);
+    d = x - perf_l[i];
+    a = perf_r[i];
+    b = pendent(i);
+    if (a <= 0 && b <= 0)   // nomes passa despres de l'ultim punt amb taxa 0
+        return (DBL_MAX);
+    // a s + b s^2 / 2 = d, escrit per no perdre precisio quan b es petit
+    s = a * a + 2 * b * d;
+    s = 2 * d / (a + sqrt((s > 0) ? s : 0));
+    if (i + 1 < perf_n && s > perf_t[i + 1] - perf_t[i])
+        s = perf_t[i + 1] - perf_t[i];
+    return (perf_t[i] + s);
+} // inversa
+
+// Clients esperats entre t0 i t1
+double clients_perfil(float t0, float t1){
+    return (intensitat(t1) - intensitat(t0));
+} // clients_perfil
+
+// Instant de l'arribada seguent a la de ta: exponencial de mitjana
+// temps_arribada si no hi ha perfil, i si n'hi ha per inversio de la
+// intensitat acumulada (FLT_MAX si ja no n'hi ha cap mes)
+float seguent_arribada(float ta){
+    double t;
+
+    if (perf_n == 0)
+        return (ta + expo_flux(ALEA_ARRIBADES, temps_arribada));
+    t = inversa(intensitat(ta) + expo_flux(ALEA_ARRIBADES, 1));
+    return ((t < FLT_MAX) ? (float) t : FLT_MAX);
+} // seguent_arribada
@@ -0,0 +1,34 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Declaracions de les arribades amb taxa variable en el temps (-l fitxer)
+ *
+ * El fitxer de text te una linia per punt del perfil, ordenades per temps:
+ *
+ *   temps taxa
+ *
+ * temps en unitats del model i taxa en clients per unitat de temps (>= 0).
+ * Una linia amb la paraula "lineal" interpola la taxa entre els punts;
+ * per defecte ("esglao") cada taxa es mante fins al punt seguent. Abans
+ * del primer punt i despres de l'ultim la taxa es la del punt. Les linies
+ * buides i les que comencen per # es salten; el separador pot ser espai,
+ * tabulador, , o ;.
+ *
+ * File:   perfil.h
+ * Author: Dolors Sala
+ */
+
+#ifndef PERFIL_H
+#define	PERFIL_H
+
+#define PERFIL_ESGLAO   0    // taxa constant a trossos
+#define PERFIL_LINEAL   1    // taxa lineal a trossos
+
+int llegeix_perfil(const char *nom);
+void allibera_perfil(void);
+int hi_ha_perfil(void);
+double clients_perfil(float t0, float t1);
+float seguent_arribada(float ta);
+
+#endif	/* PERFIL_H */
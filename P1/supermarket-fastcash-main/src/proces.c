@@ -0,0 +1,148 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Capa d'interaccio de processos sobre l'agenda (veure proces.h).
+ *
+ * Els processos es guarden en una taula indexada per id (l'on dels events
+ * PROCES). Els que acaben tornen a una reserva i es reutilitzen amb el
+ * mateix id, de manera que crear un proces no reserva memoria un cop la
+ * taula ha arribat a la mida necessaria. L'estat es privat de cada fil,
+ * com l'agenda, perque les replicacions puguin fer servir processos.
+ *
+ * File:   proces.c
+ * Author: Dolors Sala
+ */
+
+#include <string.h>
+#include "sev.h"
+#include "agenda.h"
+#include "proces.h"
+
+static _Thread_local sproces **taula;   // taula[id]: proces amb aquest id
+static _Thread_local int n_taula;       // processos creats (ids 0..n_taula-1)
+static _Thread_local int max_taula;     // capacitat de la taula
+static _Thread_local sproces *reserva;  // processos acabats per reutilitzar
+
+// Crea un proces nou amb el cos donat, sense activar-lo
+sproces *crea_proces(fproces cos){
+    sproces *p, **nova;
+
+    if (reserva != NULL){
+        p = reserva;
+        reserva = p->seg;
+    }else{
+        if (n_taula == max_taula){
+            max_taula = (max_taula > 0) ? 2 * max_taula : N;
+            nova = (sproces **) realloc(taula, max_taula * sizeof(sproces *));
+            if (nova == NULL)
+                ERROR((ofile, "ERROR: allocating memory in crea_proces\n"));
+            taula = nova;
+        }
+        p = (sproces *) malloc(sizeof(sproces));
+        if (p == NULL)
+            ERROR((ofile, "ERROR: allocating memory in crea_proces\n"));
+        p->id = n_taula;
+        taula[n_taula++] = p;
+    }
+    p->pc = 0;
+    p->cos = cos;
+    p->seg = NULL;
+    memset(&p->dades, 0, sizeof(p->dades));
+    return (p);
+} // crea_proces
+
+// Executa el proces ara mateix fins que es suspen o acaba
+void activa_proces(sproces *p, float ta){
+    p->cos(p, ta);
+} // activa_proces
+
+// Programa la reactivacio del proces a l'instant quan
+void programa_proces(sproces *p, float quan){
+    posa_agenda(quan, crea_esdev(PROCES, quan, p->id));
+} // programa_proces
+
+// Reactiva el proces id (event PROCES de l'agenda a l'instant ta)
+void repren_proces(int id, float ta){
+    if (id < 0 || id >= n_taula)
+        ERROR((ofile, "ERROR: proces %d desconegut a %.4f\n", id, ta));
+    taula[id]->cos(taula[id], ta);
+} // repren_proces
+
+// El proces ha acabat: torna a la reserva
+void acaba_proces(sproces *p){
+    p->cos = NULL;
+    p->seg = reserva;
+    reserva = p;
+} // acaba_proces
+
+// Allibera tots els processos del fil
+void allibera_processos(void){
+    int i;
+
+    for (i = 0; i < n_taula; i++)
+        free(taula[i]);
+    free(taula);
+    taula = NULL;
+    n_taula = max_taula = 0;
+    reserva = NULL;
+} // allibera_processos
+
+// Inicialitza un recurs lliure sense ningu esperant
+void ini_recurs(srecurs *r){
+    r->propietari = NA;
+    r->espera = NULL;
+    r->ini = 0;
+    r->lon = 0;
+    r->max = 0;
+} // ini_recurs
+
+// Allibera la memoria del recurs
+void elim_recurs(srecurs *r){
+    free(r->espera);
+    ini_recurs(r);
+} // elim_recurs
+
+// El proces p demana el recurs r: si es lliure el pren (retorna 1) i si no
+// es posa al final de la cua d'espera (retorna 0)
+int agafa_recurs(sproces *p, srecurs *r){
+    int *nou, i, m;
+
+    if (r->propietari == NA){
+        r->propietari = p->id;
+        return (1);
+    }
+    if (r->lon == r->max){   // dobla el vector circular i el deixa ordenat
+        m = (r->max > 0) ? 2 * r->max : CUA_MAX;
+        nou = (int *) malloc(m * sizeof(int));
+        if (nou == NULL)
+            ERROR((ofile, "ERROR: allocating memory in agafa_recurs\n"));
+        for (i = 0; i < r->lon; i++)
+            nou[i] = r->espera[(r->ini + i) % r->max];
+        free(r->espera);
+        r->espera = nou;
+        r->ini = 0;
+        r->max = m;
+    }
+    r->espera[(r->ini + r->lon) % r->max] = p->id;
+    r->lon++;
+    return (0);
+} // agafa_recurs
+
+// El proces p deixa el recurs r. Si algu l'espera, el primer el pren i es
+// reactiva immediatament (a l'instant ta, abans de continuar amb p).
+void allibera_recurs(sproces *p, srecurs *r, float ta){
+    int id;
+
+    if (r->propietari != p->id)
+        ERROR((ofile, "ERROR: el proces %d deixa un recurs que no te a %.4f\n", p->id, ta));
+    if (r->lon == 0){
+        r->propietari = NA;
+        return;
+    }
+    id = r->espera[r->ini];
+    r->ini = (r->ini + 1) % r->max;
+    r->lon--;
+    r->propietari = id;
+    repren_proces(id, ta);
+} // allibera_recurs
@@ -0,0 +1,94 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Declaracions de la capa d'interaccio de processos
+ *
+ * Un proces (client, caixer...) es una corrutina sense pila: una funcio
+ * void cos(sproces *p, float ta) que es torna a cridar cada cop que el
+ * proces es reactiva i continua on ho havia deixat gracies a un switch
+ * sobre p->pc (com els protothreads). Les variables locals NO es
+ * conserven entre reactivacions: l'estat del proces va a p->dades.
+ *
+ *   static void client(sproces *p, float ta){
+ *       sdades *d = (sdades *) &p->dades;
+ *       PROC_INICI(p);
+ *       WAIT_FOR(p, &caixer);     // espera el recurs si esta ocupat
+ *       HOLD(p, ta, d->tse);      // passa el temps
+ *       RELEASE(p, &caixer, ta);  // el dona al primer que l'espera
+ *       PROC_FI(p);
+ *   }
+ *
+ * Les reactivacions programades (HOLD, programa_proces) son events PROCES
+ * de l'agenda amb on = p->id, que el bucle de simulacio passa a
+ * repren_proces. Un canvi de context es una crida a funcio.
+ * Restriccio: nomes hi pot haver un HOLD o WAIT_FOR per linia.
+ *
+ * File:   proces.h
+ * Author: Dolors Sala
+ */
+
+#ifndef PROCES_H
+#define	PROCES_H
+
+#include "stats.h"
+
+#define PROCDADES   64   // bytes d'estat propi de cada proces
+
+typedef struct sproces sproces;
+typedef void (*fproces)(sproces *p, float ta);
+
+struct sproces {
+    int id;                 // identificador (on de l'event PROCES)
+    int pc;                 // punt on continua: 0 a l'inici, __LINE__ despres
+    fproces cos;            // funcio del proces
+    sproces *seg;           // seguent proces lliure (reserva de processos)
+    union {                 // estat propi del proces (alineat per qualsevol tipus)
+        double d;
+        long long ll;
+        void *p;
+        char c[PROCDADES];
+    } dades;
+};
+
+// Recurs que nomes pot tenir un proces cada cop (p.ex. un caixer)
+typedef struct {
+    int propietari;         // id del proces que el te (NA si es lliure)
+    int *espera;            // vector circular dels processos que l'esperen
+    int ini;                // primer que espera
+    int lon;                // processos que esperen
+    int max;                // capacitat del vector (creix sota demanda)
+} srecurs;
+
+#define PROC_INICI(p)   switch ((p)->pc) { case 0:
+#define PROC_FI(p)      } acaba_proces(p); return
+
+// Suspen el proces fins a l'instant quan
+#define HOLD_UNTIL(p, quan) \
+    do { (p)->pc = __LINE__; programa_proces((p), (quan)); return; case __LINE__:; } while (0)
+
+// Suspen el proces durant t unitats de temps
+#define HOLD(p, ta, t)      HOLD_UNTIL((p), (ta) + (t))
+
+// Espera a tenir el recurs r (si es lliure, el pren i continua sense parar)
+#define WAIT_FOR(p, r) \
+    do { if (!agafa_recurs((p), (r))) { (p)->pc = __LINE__; return; case __LINE__:; } } while (0)
+
+// Deixa el recurs r: el primer proces que l'espera el pren i continua ara
+#define RELEASE(p, r, ta)   allibera_recurs((p), (r), (ta))
+
+sproces *crea_proces(fproces cos);
+void activa_proces(sproces *p, float ta);
+void programa_proces(sproces *p, float quan);
+void repren_proces(int id, float ta);
+void acaba_proces(sproces *p);
+void allibera_processos(void);
+void ini_recurs(srecurs *r);
+void elim_recurs(srecurs *r);
+int agafa_recurs(sproces *p, srecurs *r);
+void allibera_recurs(sproces *p, srecurs *r, float ta);
+
+// Model del supermercat escrit amb processos (model_proces.c)
+int simula_processos(int ntc, sstats *sts);
+
+#endif	/* PROCES_H */
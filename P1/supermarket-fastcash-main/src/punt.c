@@ -0,0 +1,103 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Punts de control: desa tot l'estat de la simulacio sequencial (rellotge,
+ * agenda, cues, estat de les caixes, estadistiques i generador aleatori) en
+ * un fitxer binari i el recupera en un altre proces, per continuar la
+ * simulacio des d'aquell instant tantes vegades com calgui.
+ *
+ * El format es binari en l'ordre de bytes de la maquina: una capçalera amb
+ * PUNTMAGIC, la versio, la mida de les estructures i la configuracio, i
+ * despres l'estat de cada modul (desa_agenda, desa_cues, desa_stats i
+ * desa_alea) en aquest ordre.
+ *
+ * File:   punt.c
+ * Author: Dolors Sala
+ */
+
+#include <string.h>
+#include "sev.h"
+#include "cua.h"
+#include "agenda.h"
+#include "stats.h"
+#include "punt.h"
+
+#define PUNTMAGIC   "SEVPUNT"   // identificador del fitxer (8 bytes amb el '\0')
+#define PUNTVERSIO  1
+
+// Capçalera del fitxer de punt de control
+typedef struct {
+    char magic[8];
+    int versio;
+    int mida_esdev;      // sizeof(esdev) i sizeof(el_cua): el fitxer nomes
+    int mida_el_cua;     // es pot llegir amb el mateix format de dades
+    int ntc;             // caixers de la simulacio desada
+    int n_rapids;        // configuracio de la simulacio desada (informativa)
+    int politica;
+    float temps_arribada;
+    float ta;            // rellotge de la simulacio
+    int bn;              // supermercat obert (1) o tancat (0)
+} spunt;
+
+// Desa l'estat de la simulacio a l'instant ta al fitxer nom.
+// Retorna 0 si va be i -1 si no s'ha pogut escriure.
+int desa_punt(const char *nom, float ta, int bn, scua *cues, int ntc, sstats *sts){
+    FILE *f;
+    spunt p;
+    int ok;
+
+    f = fopen(nom, "wb");
+    if(f == NULL)
+        return(-1);
+    memset(&p, 0, sizeof(p));
+    strcpy(p.magic, PUNTMAGIC);
+    p.versio = PUNTVERSIO;
+    p.mida_esdev = sizeof(esdev);
+    p.mida_el_cua = sizeof(el_cua);
+    p.ntc = ntc;
+    p.n_rapids = n_rapids;
+    p.politica = politica;
+    p.temps_arribada = temps_arribada;
+    p.ta = ta;
+    p.bn = bn;
+    ok = fwrite(&p, sizeof(p), 1, f) == 1;
+    ok = ok && desa_agenda(f) == 0;
+    ok = ok && desa_cues(f, cues, ntc) == 0;
+    ok = ok && desa_stats(f, sts, ntc) == 0;
+    ok = ok && desa_alea(f) == 0;
+    if(fclose(f) != 0)
+        ok = 0;
+    return(ok ? 0 : -1);
+} // desa_punt
+
+// Recupera l'estat desat al fitxer nom: crea l'agenda i les cues, omple sts
+// (inicialitzat amb init_stats) i el generador aleatori del fil, i retorna
+// el rellotge a ta i l'estat del supermercat a bn.
+// Retorna 0 si va be i -1 si el fitxer no es valid per ntc caixers.
+int carrega_punt(const char *nom, float *ta, int *bn, scua **cues, int ntc, sstats *sts){
+    FILE *f;
+    spunt p;
+    int ok;
+
+    f = fopen(nom, "rb");
+    if(f == NULL)
+        return(-1);
+    ok = fread(&p, sizeof(p), 1, f) == 1;
+    ok = ok && memcmp(p.magic, PUNTMAGIC, sizeof(p.magic)) == 0 && p.versio == PUNTVERSIO;
+    ok = ok && p.mida_esdev == sizeof(esdev) && p.mida_el_cua == sizeof(el_cua);
+    if(ok && p.ntc != ntc){
+        fprintf(stderr, "ERROR punt de control %s: desat amb %d caixers i no %d\n", nom, p.ntc, ntc);
+        ok = 0;
+    }
+    ok = ok && carrega_agenda(f) == 0;
+    ok = ok && carrega_cues(f, cues, ntc) == 0;
+    ok = ok && carrega_stats(f, sts, ntc) == 0;
+    ok = ok && carrega_alea(f) == 0;
+    fclose(f);
+    if(ok){
+        *ta = p.ta;
+        *bn = p.bn;
+    }
+    return(ok ? 0 : -1);
+} // carrega_punt
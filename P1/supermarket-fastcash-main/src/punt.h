@@ -0,0 +1,19 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Declaracions dels punts de control (desar i recuperar la simulacio)
+ *
+ * File:   punt.h
+ * Author: Dolors Sala
+ */
+
+#ifndef PUNT_H
+#define	PUNT_H
+
+#include "stats.h"
+
+int desa_punt(const char *nom, float ta, int bn, scua *cues, int ntc, sstats *sts);
+int carrega_punt(const char *nom, float *ta, int *bn, scua **cues, int ntc, sstats *sts);
+
+#endif	/* PUNT_H */
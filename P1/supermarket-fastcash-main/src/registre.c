@@ -0,0 +1,110 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Registre binari per columnes dels clients atesos (-o fitxer). Cada client
+ * s'escriu quan comença el servei, que es quan se'n coneixen totes les
+ * dades. Els clients s'acumulen en un bloc en memoria i el bloc sencer
+ * s'escriu al fitxer (amb un buffer gran) quan s'omple. El format es el de
+ * la maquina i es descriu a registre.h.
+ *
+ * File:   registre.c
+ * Author: Dolors Sala
+ */
+
+#include <string.h>
+#include "sev.h"
+#include "registre.h"
+
+#define REGBUFFER   (1 << 20)   // buffer del fitxer (bytes)
+
+int registre_obert = 0;
+static FILE *freg = NULL;        // fitxer del registre
+static bregistre *bloc = NULL;   // bloc que s'esta omplint
+static long long n_reg;          // clients escrits en blocs sencers
+
+// Escriu la capçalera amb n clients al principi del fitxer
+static int escriu_capcalera(long long n){
+    cregistre c;
+
+    memset(&c, 0, sizeof(c));
+    memcpy(c.magic, REGMAGIC, sizeof(c.magic));
+    c.versio = REGVERSIO;
+    c.bloc = REGBLOC;
+    c.mida = sizeof(bregistre);
+    c.n = n;
+    return (fwrite(&c, sizeof(c), 1, freg) == 1 ? 0 : -1);
+} // escriu_capcalera
+
+// Escriu el bloc actual i el deixa buit
+static int escriu_bloc(void){
+    int ok;
+
+    ok = fwrite(bloc, sizeof(bregistre), 1, freg) == 1;
+    n_reg += bloc->n;
+    bloc->n = 0;
+    return (ok ? 0 : -1);
+} // escriu_bloc
+
+// Obre el fitxer nom per registrar els clients. Retorna 0 si va be.
+int obre_registre(const char *nom){
+    freg = fopen(nom, "wb");
+    if (freg == NULL)
+        return (-1);
+    setvbuf(freg, NULL, _IOFBF, REGBUFFER);
+    bloc = (bregistre *) calloc(1, sizeof(bregistre));
+    if (bloc == NULL || escriu_capcalera(0) != 0){
+        fclose(freg);
+        free(bloc);
+        return (-1);
+    }
+    n_reg = 0;
+    registre_obert = 1;
+    return (0);
+} // obre_registre
+
+// Afegeix un client al bloc actual: arribada, classe, caixer, longitud de
+// la cua quan hi entra, inici del servei i temps de servei
+void registra_client(float tar, int classe, int caixer, int lon, float inici, float tse){
+    int i = bloc->n;
+
+    bloc->tar[i] = tar;
+    bloc->inici[i] = inici;
+    bloc->tse[i] = tse;
+    bloc->sortida[i] = inici + tse;
+    bloc->caixer[i] = caixer;
+    bloc->lon[i] = lon;
+    bloc->classe[i] = (char) classe;
+    if (++bloc->n == REGBLOC && escriu_bloc() != 0){
+        fprintf(stderr, "ERROR registre: no es pot escriure el registre de clients\n");
+        exit(EXIT_FAILURE);
+    }
+} // registra_client
+
+// Escriu l'ultim bloc (incomplet, amb la resta a zero), actualitza el
+// nombre de clients de la capçalera i tanca el fitxer. Retorna 0 si va be.
+int tanca_registre(void){
+    int ok = 1, i;
+
+    if (!registre_obert)
+        return (0);
+    if (bloc->n > 0){
+        i = bloc->n;
+        memset(bloc->tar + i, 0, (REGBLOC - i) * sizeof(float));
+        memset(bloc->inici + i, 0, (REGBLOC - i) * sizeof(float));
+        memset(bloc->tse + i, 0, (REGBLOC - i) * sizeof(float));
+        memset(bloc->sortida + i, 0, (REGBLOC - i) * sizeof(float));
+        memset(bloc->caixer + i, 0, (REGBLOC - i) * sizeof(int));
+        memset(bloc->lon + i, 0, (REGBLOC - i) * sizeof(int));
+        memset(bloc->classe + i, 0, (REGBLOC - i) * sizeof(char));
+        ok = escriu_bloc() == 0;
+    }
+    ok = ok && fseek(freg, 0, SEEK_SET) == 0 && escriu_capcalera(n_reg) == 0;
+    if (fclose(freg) != 0)
+        ok = 0;
+    free(bloc);
+    bloc = NULL;
+    freg = NULL;
+    registre_obert = 0;
+    return (ok ? 0 : -1);
+} // tanca_registre
@@ -0,0 +1,63 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Declaracions del registre binari per columnes de cada client ates
+ *
+ * El fitxer te una capçalera (cregistre) i despres blocs de mida fixa
+ * (bregistre) amb REGBLOC clients guardats per columnes. L'ultim bloc
+ * nomes te n clients valids. Amb numpy es pot llegir directament:
+ *
+ *   B = 4096
+ *   bloc = np.dtype([('n','<i4'), ('res','<i4'),
+ *                    ('tar','<f4',B), ('inici','<f4',B), ('tse','<f4',B),
+ *                    ('sortida','<f4',B), ('caixer','<i4',B), ('lon','<i4',B),
+ *                    ('classe','i1',B)])
+ *   b = np.memmap(nom, dtype=bloc, mode='r', offset=32)
+ *   tar = b['tar'].reshape(-1)[:n]    # n: capçalera o suma de b['n']
+ *
+ * File:   registre.h
+ * Author: Dolors Sala
+ */
+
+#ifndef REGISTRE_H
+#define	REGISTRE_H
+
+#define REGBLOC      4096        // clients de cada bloc del fitxer
+#define REGMAGIC     "SEVCLIEN"
+#define REGVERSIO    1
+
+// Capçalera del fitxer (32 bytes)
+typedef struct {
+    char magic[8];       // REGMAGIC
+    int  versio;         // REGVERSIO
+    int  bloc;           // REGBLOC
+    int  mida;           // sizeof(bregistre)
+    int  res;            // reservat (alineacio)
+    long long n;         // clients al fitxer
+}cregistre;
+
+// Bloc de clients guardats per columnes
+typedef struct {
+    int   n;                  // clients valids del bloc
+    int   res;                // reservat (alineacio)
+    float tar[REGBLOC];       // arribada al supermercat
+    float inici[REGBLOC];     // inici del servei
+    float tse[REGBLOC];       // temps de servei
+    float sortida[REGBLOC];   // sortida del caixer
+    int   caixer[REGBLOC];    // caixer que l'atén
+    int   lon[REGBLOC];       // clients a la cua quan hi entra (0 si passa directe)
+    char  classe[REGBLOC];    // 1 client rapid, 0 lent
+}bregistre;
+
+extern int registre_obert;   // hi ha un fitxer de registre obert
+
+// Nomes es crida la funcio si el registre esta obert
+#define REGISTRA_CLIENT(tar, classe, caixer, lon, inici, tse) \
+    do { if (registre_obert) registra_client((tar), (classe), (caixer), (lon), (inici), (tse)); } while (0)
+
+int obre_registre(const char *nom);
+void registra_client(float tar, int classe, int caixer, int lon, float inici, float tse);
+int tanca_registre(void);
+
+#endif	/* REGISTRE_H */
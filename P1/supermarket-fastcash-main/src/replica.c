@@ -0,0 +1,191 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Replicacions independents executades en paral·lel en un conjunt de fils.
+ * Cada replicacio te el seu propi flux aleatori (ini_alea(llavor, r)), la
+ * seva agenda i les seves estadistiques. En acabar, els histogrames de
+ * cada caixa se sumen i es dona la mitjana entre replicacions amb un
+ * interval de confiança t de Student.
+ *
+ * Amb -v cada replicacio fa passar tambe els clients per dues cues M/M/c a
+ * l'ombra, una amb els caixers rapids i l'altra amb la resta (els mateixos
+ * instants d'arribada i la part exponencial dels mateixos serveis). La seva
+ * espera total te esperança coneguda (espera_mmc) i fa de variable de
+ * control del temps de cua.
+ *
+ * File:   replica.c
+ * Author: Dolors Sala
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+#include "sev.h"
+#include "stats.h"
+#include "replica.h"
+
+#define REPMESURES  5   // mesures que es guarden de cada replicacio
+
+// Noms de les mesures de cada replicacio
+static const char *nom_mesura[REPMESURES] = {
+    "Clients atesos                    ",
+    "Nombre promig de clients a cua    ",
+    "Temps promig de cua               ",
+    "Temps promig de servei            ",
+    "Temps promig al super             "
+};
+
+// Estat compartit pels fils que executen les replicacions
+typedef struct {
+    int ntc;                  // nombre total de caixers
+    int nrep;                 // nombre de replicacions
+    unsigned long long llavor;
+    int n_rapids;             // configuracio del fil principal (n_rapids i fraccio_rapids
+    double fraccio_rapids;    // son propis de cada fil)
+    int seguent;              // seguent replicacio per executar
+    int ret;                  // 0 si totes les replicacions acaben be
+    double *y[REPMESURES];    // mesures de cada replicacio [REPMESURES][nrep]
+    double *x;                // espera total de les cues a l'ombra [nrep] (amb -v)
+    sstats total;             // suma dels histogrames de totes les replicacions
+    pthread_mutex_t mutex;
+} srepl;
+
+// Nombre de nuclis disponibles
+int nombre_nuclis(void){
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0 ? (int) n : 1);
+} // nombre_nuclis
+
+// Calcula les mesures de la replicacio r a partir de les seves estadistiques
+static void mesures_replica(srepl *p, int r, sstats *s){
+    int c;
+    double lq = 0.0;
+
+    for(c = 0; c < p->ntc; c++)
+        lq += mean_thist(s->qhist[c], s->nqhist[c]);
+    p->y[0][r] = suma_vect(s->nca, p->ntc);
+    p->y[1][r] = lq;
+    p->y[2][r] = mean_stn_hdr(s->dqhist, p->ntc);
+    p->y[3][r] = mean_stn_hdr(s->dshist, p->ntc);
+    p->y[4][r] = mean_stn_hdr(s->dthist, p->ntc);
+} // mesures_replica
+
+// Fil de treball: agafa replicacions pendents fins que no en queden
+static void *treballador(void *arg){
+    srepl *p = (srepl *) arg;
+    sstats s;
+    int r, ret;
+
+    n_rapids = p->n_rapids;
+    fraccio_rapids = p->fraccio_rapids;
+    for(;;){
+        pthread_mutex_lock(&p->mutex);
+        r = p->seguent++;
+        pthread_mutex_unlock(&p->mutex);
+        if(r >= p->nrep)
+            break;
+
+        ini_alea(p->llavor, r);
+        init_stats(&s, p->ntc);
+        if(escalfament)
+            ini_mser(&s);
+        if(p->x != NULL)
+            ini_ombra(&s, p->ntc);
+        ret = simula(p->ntc, &s);
+        mesures_replica(p, r, &s);
+        if(p->x != NULL)
+            p->x[r] = espera_ombra(&s);
+
+        pthread_mutex_lock(&p->mutex);
+        suma_stats(&p->total, &s, p->ntc);
+        if(ret != 0) p->ret = ret;
+        pthread_mutex_unlock(&p->mutex);
+        free_stats(s, p->ntc);
+    }
+    allibera_traca();
+    allibera_alea();
+    return (NULL);
+} // treballador
+
+// Executa nrep replicacions de la simulacio amb ntc caixers en nfils fils
+// (0 = tants com nuclis) i escriu els resultats agregats a ofile
+int executa_replicacions(int ntc, int nrep, int nfils, long int llavor){
+    srepl p;
+    pthread_t *fils;
+    int f, r, m;
+    double mean, CI, mux, beta, reduccio;
+
+    if(nfils <= 0) nfils = nombre_nuclis();
+    if(nfils > nrep) nfils = nrep;
+
+    p.ntc = ntc;
+    p.nrep = nrep;
+    p.llavor = (unsigned long long) llavor;
+    p.n_rapids = n_rapids;
+    p.fraccio_rapids = fraccio_rapids;
+    p.seguent = 0;
+    p.ret = 0;
+    for(m = 0; m < REPMESURES; m++){
+        p.y[m] = (double *) calloc(nrep, sizeof(double));
+        if(p.y[m] == NULL)
+            ERROR((ofile, "ERROR: allocating memory in executa_replicacions\n"));
+    }
+    p.x = NULL;
+    if(control_mmc && (p.x = (double *) calloc(nrep, sizeof(double))) == NULL)
+        ERROR((ofile, "ERROR: allocating memory in executa_replicacions\n"));
+    init_stats(&p.total, ntc);
+    pthread_mutex_init(&p.mutex, NULL);
+
+    fils = (pthread_t *) malloc(nfils * sizeof(pthread_t));
+    if(fils == NULL)
+        ERROR((ofile, "ERROR: allocating memory in executa_replicacions\n"));
+    for(f = 0; f < nfils; f++)
+        if(pthread_create(&fils[f], NULL, treballador, &p) != 0)
+            ERROR((ofile, "ERROR: creating thread %d in executa_replicacions\n", f));
+    for(f = 0; f < nfils; f++)
+        pthread_join(fils[f], NULL);
+
+    // Resultats de cada replicacio i interval de confiança entre replicacions
+    fprintf(ofile,"\n");
+    MESSAGE((ofile, "-----------------------------------------------------------\n"));
+    MESSAGE((ofile, "----- Replicacions independents ---------------------------\n"));
+    MESSAGE((ofile, "-----------------------------------------------------------\n"));
+    fprintf(ofile,"Replicacions: %d, Fils: %d, Llavor: %ld\n\n", nrep, nfils, llavor);
+    fprintf(ofile,"Rep. Clients   Long.cua  Temps cua  T.servei  T.super\n");
+    for(r = 0; r < nrep; r++)
+        fprintf(ofile,"%4d %7.0lf %10.2lf %10.2lf %9.2lf %8.2lf\n",
+                r, p.y[0][r], p.y[1][r], p.y[2][r], p.y[3][r], p.y[4][r]);
+    fprintf(ofile,"\n");
+    fprintf(ofile,"Intervals de confiança al %.0lf%% (t de Student, %d graus de llibertat, t = %.4lf)\n",
+            100 * (1 - STSALPHA), nrep - 1, t_student(nrep - 1, STSALPHA));
+    for(m = 0; m < REPMESURES; m++){
+        CI = compute_confidence_interval_t(p.y[m], nrep, STSALPHA, &mean);
+        fprintf(ofile,"%s: %10.4lf CI %.4lf (%.4lf, %.4lf)\n",
+                nom_mesura[m], mean, CI, mean - CI, mean + CI);
+    }
+    fprintf(ofile,"\n");
+    if(p.x != NULL){
+        // Temps de cua amb la variable de control (n - 2 graus de llibertat)
+        for(mean = 0, r = 0; r < nrep; r++)
+            mean += p.x[r] / nrep;
+        mux = espera_mmc(fraccio_rapids / temps_arribada, 1.0 / SERVICE, n_rapids, TANCARTIME - OBRIRTIME)
+            + espera_mmc((1 - fraccio_rapids) / temps_arribada, 1.0 / SERVICE, ntc - n_rapids,
+                         TANCARTIME - OBRIRTIME);
+        fprintf(ofile,"Variable de control: espera total M/M/%d + M/M/%d a l'ombra, esperada %.2lf, observada %.2lf\n",
+                n_rapids, ntc - n_rapids, mux, mean);
+        CI = compute_control_variate_ci(p.y[2], p.x, nrep, mux, STSALPHA, &mean, &beta, &reduccio);
+        fprintf(ofile,"%s: %10.4lf CI %.4lf (%.4lf, %.4lf), beta %.6lf, reduccio de variancia %.2lf\n\n",
+                nom_mesura[2], mean, CI, mean - CI, mean + CI, beta, reduccio);
+    }
+
+    // Histogrames sumats de totes les replicacions
+    collect_stats(p.total, ntc);
+
+    pthread_mutex_destroy(&p.mutex);
+    free_stats(p.total, ntc);
+    for(m = 0; m < REPMESURES; m++)
+        free(p.y[m]);
+    free(p.x);
+    free(fils);
+    return (p.ret);
+} // executa_replicacions
@@ -0,0 +1,32 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Declaracions per executar replicacions independents en paral·lel
+ *
+ * File:   replica.h
+ * Author: Dolors Sala
+ */
+
+#ifndef REPLICA_H
+#define	REPLICA_H
+
+#include "stats.h"
+#include "agenda.h"
+
+// Estat d'una simulacio sequencial en curs (sev.c); l'agenda i el
+// generador aleatori son els del fil
+typedef struct {
+    float ta;       // rellotge
+    int bn;         // supermercat obert (1) o tancat (0)
+    scua *cues;     // cues dels caixers [ntc]
+    long long it;   // tiquet del seguent client (amb -t)
+} ssim;
+
+void ini_simulacio(ssim *s, int ntc);
+int tracta_esdev(ssim *s, esdev e, int ntc, sstats *sts);
+int simula(int ntc, sstats *sts);
+int nombre_nuclis(void);
+int executa_replicacions(int ntc, int nrep, int nfils, long int llavor);
+
+#endif	/* REPLICA_H */
@@ -0,0 +1,300 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Estimador per divisio (multilevel splitting, a l'estil RESTART) de la
+ * probabilitat que durant el dia alguna cua arribi a K clients esperant
+ * (-k K). Amb simulacio directa un esdeveniment de probabilitat 1e-6
+ * necessita milions de dies; aqui les trajectories que s'hi acosten es
+ * multipliquen.
+ *
+ * La funcio d'importancia es la cua mes llarga i hi ha un nivell a cada
+ * longitud 1..K. Quan una trajectoria arriba al nivell j es fa una foto de
+ * l'estat (agenda i cues, amb desa_agenda i desa_cues com els punts de
+ * control) i se'n fan R[j] continuacions: la primera continua amb el
+ * generador que tenia i les altres parteixen de la foto amb un flux
+ * aleatori nou. Una trajectoria acaba quan arriba al nivell seguent o
+ * quan s'acaba el dia (agenda buida).
+ *
+ *   1) Prova pilot (esforç fix): RSTPILOT trajectories per nivell,
+ *      començant de les fotos del nivell anterior, estimen la probabilitat
+ *      p[j] de passar de cada nivell al seguent. El factor de divisio mig
+ *      m[j] = 1/p[j+1] (entre 1 i RSTMAXR) fa que el nombre de trajectories
+ *      es mantingui. Cada divisio en fa floor(m[j]) o floor(m[j]) + 1 a
+ *      l'atzar (flux ALEA_GENERAL de la trajectoria) amb mitjana m[j]: amb
+ *      l'arrodoniment a l'enter, p = 0.6 donaria 1 i no es dividiria mai.
+ *   2) Execucio: narrels trajectories arrel independents amb els m[j] fixats.
+ *      Si l'arrel i arriba a K h_i vegades, Y_i = h_i / (m[0]...m[K-2]) es
+ *      un estimador sense biaix de la probabilitat i, com que les arrels
+ *      son independents, l'interval de confiança surt de la variancia de Y.
+ * La prova pilot fa servir fluxos aleatoris separats (llavor complementada)
+ * perque els m[j] no depenguin dels numeros de l'execucio.
+ *
+ * File:   restart.c
+ * Author: Dolors Sala
+ */
+
+#define _POSIX_C_SOURCE 200809L   // open_memstream i fmemopen
+#include <string.h>
+#include "sev.h"
+#include "cua.h"
+#include "agenda.h"
+#include "stats.h"
+#include "replica.h"
+#include "restart.h"
+
+// Estat desat d'una simulacio (foto en memoria)
+typedef struct {
+    char *buf;       // agenda i cues en el format dels punts de control
+    size_t mida;
+    float ta;
+    int bn;
+    long long it;
+} sfoto;
+
+// Estat de l'estimador
+typedef struct {
+    int ntc;
+    int k;                     // nivells 1..k (la capacitat)
+    double *m;                 // factor de divisio mig a cada nivell [k]
+    sfoto *foto;               // foto de cada nivell de la branca actual [k]
+    sstats sts;                // estadistiques de treball (no es fan servir)
+    unsigned long long llavor; // llavor de l'arrel actual
+    int clon;                  // continuacions de l'arrel actual
+    long long nesd;            // events tractats
+    long long nclons;          // continuacions noves (fotos recuperades)
+} srst;
+
+// Clients a la cua mes llarga
+static int cua_mes_llarga(scua *cues, int ntc){
+    int c, m = 0;
+
+    for (c = 0; c < ntc; c++)
+        if (cues[c].lon_cua > m)
+            m = cues[c].lon_cua;
+    return (m);
+} // cua_mes_llarga
+
+// Avança la simulacio fins que la cua mes llarga arriba a nivell (retorna
+// 1) o s'acaba el dia (retorna 0)
+static int avanca(srst *r, ssim *s, int nivell){
+    esdev e;
+
+    while (treu_agenda(s->ta, &e) != 0){
+        r->nesd++;
+        if (tracta_esdev(s, e, r->ntc, &r->sts) != 0)
+            ERROR((ofile, "ERROR: esdeveniment desconegut a l'estimador per divisio\n"));
+        if (e.que == ARRIBADA && cua_mes_llarga(s->cues, r->ntc) >= nivell)
+            return (1);
+    }
+    return (0);
+} // avanca
+
+// Allibera l'agenda i les cues de la simulacio s
+static void acaba_simulacio(srst *r, ssim *s){
+    elim_cues(s->cues, r->ntc);
+    s->cues = NULL;
+    allibera_agenda();
+} // acaba_simulacio
+
+// Desa l'estat de s a la foto f
+static void fes_foto(srst *r, sfoto *f, ssim *s){
+    FILE *m;
+    int ok;
+
+    f->buf = NULL;
+    f->mida = 0;
+    m = open_memstream(&f->buf, &f->mida);
+    if (m == NULL)
+        ERROR((ofile, "ERROR: allocating memory in fes_foto\n"));
+    ok = desa_agenda(m) == 0 && desa_cues(m, s->cues, r->ntc) == 0;
+    if (fclose(m) != 0 || !ok)
+        ERROR((ofile, "ERROR: no es pot desar l'estat a fes_foto\n"));
+    f->ta = s->ta;
+    f->bn = s->bn;
+    f->it = s->it;
+} // fes_foto
+
+// Crea a s (sense simulacio) l'estat desat a la foto f
+static void recupera_foto(srst *r, sfoto *f, ssim *s){
+    FILE *m;
+    int ok;
+
+    m = fmemopen(f->buf, f->mida, "rb");
+    if (m == NULL)
+        ERROR((ofile, "ERROR: no es pot llegir l'estat a recupera_foto\n"));
+    s->cues = NULL;
+    ok = carrega_agenda(m) == 0 && carrega_cues(m, &s->cues, r->ntc) == 0;
+    fclose(m);
+    if (!ok)
+        ERROR((ofile, "ERROR: no es pot recuperar l'estat a recupera_foto\n"));
+    s->ta = f->ta;
+    s->bn = f->bn;
+    s->it = f->it;
+    r->nclons++;
+} // recupera_foto
+
+static void allibera_foto(sfoto *f){
+    free(f->buf);
+    f->buf = NULL;
+    f->mida = 0;
+} // allibera_foto
+
+// La trajectoria s acaba d'arribar al nivell j+1 (index j): es divideix en
+// floor(m[j]) o floor(m[j]) + 1 continuacions i retorna quantes arriben a
+// la capacitat
+static long long branca(srst *r, ssim *s, int j){
+    long long h = 0;
+    int c, n;
+
+    if (j == r->k - 1)
+        return (1);
+    n = (int) r->m[j];
+    if (alea(ALEA_GENERAL) < r->m[j] - n)
+        n++;
+    if (n > 1)
+        fes_foto(r, &r->foto[j], s);
+    for (c = 0; c < n; c++){
+        if (c > 0){   // continuacio nova des de la foto, amb un flux propi
+            acaba_simulacio(r, s);
+            recupera_foto(r, &r->foto[j], s);
+            ini_alea(r->llavor, ++r->clon);
+        }
+        if (avanca(r, s, j + 2))
+            h += branca(r, s, j + 1);
+    }
+    if (n > 1)
+        allibera_foto(&r->foto[j]);
+    return (h);
+} // branca
+
+// Prova pilot d'esforç fix: estima p[j], la probabilitat d'arribar al
+// nivell j+1 des del nivell j (des de l'inici per j = 0), i fixa els m[j]
+static void prova_pilot(srst *r, double *p, unsigned long long llavor){
+    sfoto *act, *seg, *t;
+    ssim s;
+    int j, i, nact = 0, nseg;
+    int id = 0;
+
+    act = (sfoto *) calloc(RSTPILOT, sizeof(sfoto));
+    seg = (sfoto *) calloc(RSTPILOT, sizeof(sfoto));
+    if (act == NULL || seg == NULL)
+        ERROR((ofile, "ERROR: allocating memory in prova_pilot\n"));
+    for (j = 0; j < r->k; j++){
+        nseg = 0;
+        if (j == 0 || nact > 0)
+            for (i = 0; i < RSTPILOT; i++){
+                ini_alea(~llavor, id++);
+                if (j == 0)
+                    ini_simulacio(&s, r->ntc);
+                else
+                    recupera_foto(r, &act[i % nact], &s);
+                if (avanca(r, &s, j + 1))
+                    fes_foto(r, &seg[nseg++], &s);
+                acaba_simulacio(r, &s);
+            }
+        p[j] = (double) nseg / RSTPILOT;
+        for (i = 0; i < nact; i++)
+            allibera_foto(&act[i]);
+        t = act; act = seg; seg = t;
+        nact = nseg;
+    }
+    for (i = 0; i < nact; i++)
+        allibera_foto(&act[i]);
+    free(act);
+    free(seg);
+
+    // m[j] divideix en arribar al nivell j+1 i compensa p[j+1]
+    for (j = 0; j < r->k - 1; j++){
+        r->m[j] = (p[j + 1] > 0) ? 1.0 / p[j + 1] : RSTMAXR;
+        if (r->m[j] > RSTMAXR) r->m[j] = RSTMAXR;
+    }
+    r->m[r->k - 1] = 1;
+} // prova_pilot
+
+// Estima la probabilitat que alguna de les ntc cues arribi a capacitat
+// clients esperant durant el dia amb narrels trajectories arrel i escriu
+// els resultats a ofile
+int executa_restart(int ntc, int capacitat, int narrels, long int llavor){
+    srst r;
+    ssim s;
+    double *p, *y, prod = 1, ppilot = 1, mean, CI, nesd_dia, dies_directa, guany, z;
+    long long h, nesd_pilot;
+    int i, j;
+
+    r.ntc = ntc;
+    r.k = capacitat;
+    r.m = (double *) malloc(capacitat * sizeof(double));
+    r.foto = (sfoto *) calloc(capacitat, sizeof(sfoto));
+    p = (double *) malloc(capacitat * sizeof(double));
+    y = (double *) malloc(narrels * sizeof(double));
+    if (r.m == NULL || r.foto == NULL || p == NULL || y == NULL)
+        ERROR((ofile, "ERROR: allocating memory in executa_restart\n"));
+    init_stats(&r.sts, ntc);
+    r.nesd = r.nclons = 0;
+
+    // Cost d'un dia de simulacio directa
+    for (i = 0; i < RSTDIES; i++){
+        ini_alea(~llavor, -1 - i);
+        ini_simulacio(&s, ntc);
+        avanca(&r, &s, capacitat + 1);
+        acaba_simulacio(&r, &s);
+    }
+    nesd_dia = (double) r.nesd / RSTDIES;
+
+    r.nesd = 0;
+    prova_pilot(&r, p, (unsigned long long) llavor);
+    nesd_pilot = r.nesd;
+    for (j = 0; j < capacitat; j++)
+        ppilot *= p[j];
+    for (j = 0; j < capacitat - 1; j++)
+        prod *= r.m[j];
+
+    r.nesd = r.nclons = 0;
+    for (i = 0; i < narrels; i++){
+        // llavor propia de cada arrel; les continuacions en son fluxos 1, 2...
+        r.llavor = (unsigned long long) llavor + ((unsigned long long) i << 32);
+        r.clon = 0;
+        ini_alea(r.llavor, 0);
+        ini_simulacio(&s, ntc);
+        h = 0;
+        if (avanca(&r, &s, 1))
+            h = branca(&r, &s, 0);
+        acaba_simulacio(&r, &s);
+        y[i] = h / prod;
+    }
+    CI = compute_confidence_interval_t(y, narrels, STSALPHA, &mean);
+
+    fprintf(ofile,"\n");
+    MESSAGE((ofile, "-----------------------------------------------------------\n"));
+    MESSAGE((ofile, "----- Probabilitat de desbordament (divisio) --------------\n"));
+    MESSAGE((ofile, "-----------------------------------------------------------\n"));
+    fprintf(ofile,"Capacitat de cua: %d clients esperant, Arrels: %d, Llavor: %ld\n\n",
+            capacitat, narrels, llavor);
+    fprintf(ofile,"Nivell  P(pilot)  Divisio\n");
+    for (j = 0; j < capacitat; j++)
+        fprintf(ofile,"%6d %9.4lf %8.2lf\n", j + 1, p[j], r.m[j]);
+    fprintf(ofile,"Estimacio de la prova pilot: %.4le (%lld events)\n\n", ppilot, nesd_pilot);
+
+    fprintf(ofile,"P(alguna cua arriba a %d) = %.4le CI %.4le (%.4le, %.4le) al %.0lf%%\n",
+            capacitat, mean, CI, mean - CI, mean + CI, 100 * (1 - STSALPHA));
+    fprintf(ofile,"Error relatiu: %.2lf%%, events: %lld, continuacions: %lld\n",
+            mean > 0 ? 100 * CI / mean : 0.0, r.nesd, r.nclons);
+    if (mean > 0 && CI > 0){
+        // Dies de simulacio directa per tenir el mateix interval
+        z = t_student(narrels - 1, STSALPHA);
+        dies_directa = z * z * mean * (1 - mean) / (CI * CI);
+        guany = dies_directa * nesd_dia / (r.nesd + nesd_pilot);
+        fprintf(ofile,"Simulacio directa equivalent: %.3le dies (%.3le events, %.1lf events/dia), %.2lf vegades mes%s\n",
+                dies_directa, dies_directa * nesd_dia, nesd_dia, guany,
+                guany < 1 ? " (amb aquesta capacitat la divisio es mes lenta)" : "");
+    }
+    fprintf(ofile,"\n");
+
+    free_stats(r.sts, ntc);
+    free(r.m);
+    free(r.foto);
+    free(p);
+    free(y);
+    return (0);
+} // executa_restart
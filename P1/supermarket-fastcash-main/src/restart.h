@@ -0,0 +1,22 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Declaracions de l'estimador per divisio (splitting) de la probabilitat
+ * que una cua arribi a la capacitat K (-k K)
+ *
+ * File:   restart.h
+ * Author: Dolors Sala
+ */
+
+#ifndef RESTART_H
+#define	RESTART_H
+
+#define RSTARRELS    1000    // trajectories arrel si no es dona -r
+#define RSTPILOT     1000    // trajectories per nivell de la prova pilot
+#define RSTMAXR      20      // factor de divisio maxim d'un nivell
+#define RSTDIES      20      // dies sencers per mesurar el cost d'un dia
+
+int executa_restart(int ntc, int capacitat, int narrels, long int llavor);
+
+#endif	/* RESTART_H */
@@ -14,27 +14,367 @@
  */
 
 #include <time.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
 #include "./sev.h"
 #include "./cua.h"
 #include "./agenda.h"
 #include "./stats.h"
+#include "./replica.h"
+#include "./pdes.h"
+#include "./punt.h"
+#include "./registre.h"
+#include "./proces.h"
+#include "./tiquets.h"
+#include "./optim.h"
+#include "./restart.h"
+#include "./perfil.h"
+#include "./telemetria.h"
 
-int main(void) {
+static volatile sig_atomic_t bolca_demanat = 0; // SIGUSR1 demana bolcar les traces
+
+static float temps_punt = -1;                 // -c: instant del punt de control (< 0 cap)
+static const char *fitxer_punt = PUNTFILENAME; // -w: fitxer on es desa
+static const char *fitxer_continua = NULL;    // -x: punt de control del qual es continua
+static int llavor_donada = 0;                 // s'ha donat -s
+static long int llavor_continua = 0;          // -s amb -x: llavor nova de la continuacio (0 = la desada)
+static const char *fitxer_registre = NULL;    // -o: registre binari dels clients atesos
+static int motor_processos = 0;               // -i: model escrit amb processos (model_proces.c)
+static const char *fitxer_tiquets = NULL;     // -t: CSV de tiquets d'on surten les arribades
+static int optimitzar = 0;                    // -z: busca la configuracio de menys caixers
+static int mesura_objectiu;                   // -z: OPT_MITJANA o OPT_P95
+static double valor_objectiu;                 // -z: temps de cua maxim
+static int capacitat = 0;                     // -k: capacitat de cua per l'estimador per divisio (0 cap)
+static const char *fitxer_perfil = NULL;      // -l: perfil de la taxa d'arribades
+static const char *segment_telemetria = NULL; // -g: segment de memoria compartida de la telemetria
+
+#ifndef SEV_SENSE_MAIN
+// Manegador de SIGUSR1: nomes marca la peticio, el bucle principal bolca
+static void demana_bolcat(int sig){
+    (void) sig;
+    bolca_demanat = 1;
+}
+#endif
+
+// Inicia a s una simulacio nova amb ntc caixers: agenda amb l'obertura i
+// el tancament i cues buides. El generador aleatori del fil s'ha
+// d'haver inicialitzat abans (ini_alea).
+void ini_simulacio(ssim *s, int ntc){
     esdev e;
-    scua *cues = NULL; // vector dinamic de dimensio ntc
+
+    s->ta = 0;
+    s->bn = 0;
+    s->it = 0;
+    s->cues = NULL;
+    ini_agenda(N);
+    crea_cues(&s->cues, CUA_MAX, ntc);
+
+    //for(q = 0; q < ntc; q++){
+        e = crea_esdev(OBRIR, OBRIRTIME, NA);
+        posa_agenda(s->ta, e);
+    //}
+    // Tancar fa referència a tancar supermercat i no una caixa en concret
+    // (amb tiquets tanca quan s'acaben)
+    if(tiquets == NULL){
+        e = crea_esdev(TANCAR, TANCARTIME, NA);
+        posa_agenda(s->ta, e);
+    }
+} // ini_simulacio
+
+// Tracta l'event e, ja tret de l'agenda, sobre la simulacio s i acumula
+// les estadistiques a sts. Retorna 0 si va be i -1 si l'event es desconegut.
+int tracta_esdev(ssim *s, esdev e, int ntc, sstats *sts){
+    scua *cues = s->cues; // vector dinamic de dimensio ntc
     el_cua c;
     float t;
-    float ta = 0; // Temps actual que avança la simulació
-    float tant = 0; // Temps de l'event anterior per saber quan ha passat entre els dos events per stats
-    int bn;     // bandera que indica si caixa oberta 1 o tancada 0  
-    int *caixa;  // indica si el caixer [i] esta ocupat 1 o no 0
-    float tmax; // temps maxim en el sistema
-    int nca;    // nombre de clients atesos
-    int ntc;    // nombre total de caixers
-    int j, q;
+    float ta = s->ta; // Temps actual que avança la simulació
+    int bn = s->bn;   // bandera que indica si caixa oberta 1 o tancada 0
+    int j;
+    long long it = s->it; // tiquet del client que arriba (amb -t)
+    int ret = 0;
+
+    switch (e.que){
+        case OBRIR:
+            bn = 1;
+            //caixa = 0;
+            e.on = NA;
+            if(tiquets != NULL)
+                t = tiquets[0].temps;
+            else
+                t = seguent_arribada(OBRIRTIME);   // temps_arribada o perfil (-l)
+            TRACA(TRACAalea, ta, 'A', ARRIBADA, e.on, 0, t);
+            e = crea_esdev(ARRIBADA, t, e.on);
+            posa_agenda(ta, e);
+            break;
+        case ARRIBADA:
+            if(bn == 1){
+                ta = e.quan;
+                // Decideix si el client es ràpid o lent (fraccio_rapids, 30% per defecte)
+                // (amb tiquets, segons els articles)
+                int esRapid = (tiquets != NULL) ? classe_tiquet(it) : (alea(ALEA_CLASSE) < fraccio_rapids) ? 1 : 0;
+                int ini = esRapid ? 0 : n_rapids;
+                int fin = esRapid ? n_rapids - 1 : ntc - 1;
+                // La politica d'encaminament tria el caixer del rang
+                c.on = tria_cua(cues, ini, fin, ta);
+                // El temps de servei surt del flux del caixer (o del tiquet)
+                t = (tiquets != NULL) ? servei_tiquet(it, c.on) : temps_servei(c.on);
+                inc_ombra(sts, ini, fin, ta, t - 1);   // variable de control (-v): part exponencial
+                TRACA(TRACAalea, ta, 'S', ARRIBADA, c.on, 0, t);
+                if(cues[c.on].caixa == 0){
+                    // caixer lliure: comença el servei
+                    e.on = c.on;
+                    TRACA(TRACAquinaCua, ta, 'B', ARRIBADA, e.on, 0, esRapid);
+                    posa_caixa(&cues[e.on], 1);
+                    cues[e.on].fi_servei = ta+t;
+                    TRACA(TRACAserv, ta, 'S', ARRIBADA, e.on, 0, t);
+                    inc_servei(sts, e.on, ta, 0, t, 0);
+                    REGISTRA_CLIENT(ta, esRapid, e.on, 0, ta, t);
+                    e = crea_esdev(SORTIDA, ta+t, e.on);
+                    posa_agenda(ta, e);
+                }else{ // posar element a la cua d'espera
+                    TRACA(TRACAquinaCua, ta, 'C', ARRIBADA, c.on, cues[c.on].lon_cua, esRapid);
+                    c.tar = ta;
+                    c.tse = t;
+                    c.lon = cues[c.on].lon_cua;
+                    actualitzar_stats_caixer(&cues[c.on], c.on, ta, sts);
+                    posa_cua(&cues[c.on], ta, c);
+                }
+                // Decidir la seguent arribada
+                if(tiquets != NULL){
+                    if(++it >= n_tiquets)
+                        break;   // no queden tiquets
+                    t = tiquets[it].temps;
+                }else
+                    t = seguent_arribada(ta);   // temps_arribada o perfil (-l)
+                e.on = NA;
+                TRACA(TRACAalea, ta, 'A', ARRIBADA, e.on, 0, t - ta);
+                e = crea_esdev(ARRIBADA, t, e.on);
+                posa_agenda(ta, e);
+            }//bn==1
+            break;
+        case SORTIDA:
+            ta = e.quan;
+            inc_atesos(sts, e.on, ta);
+            if(cues[e.on].lon_cua > 0)
+                actualitzar_stats_caixer(&cues[e.on], e.on, ta, sts);
+            j  = treu_cua(&cues[e.on], ta, &c);
+            if (j != 0){
+                t = e.quan - c.tar;
+                inc_servei(sts, e.on, ta, t, c.tse, 1);
+                REGISTRA_CLIENT(c.tar, e.on < n_rapids, e.on, c.lon, ta, c.tse);
+                TRACA(TRACAserv, ta, 'E', SORTIDA, e.on, cues[e.on].lon_cua, t);
+                t = c.tse;
+                TRACA(TRACAserv, ta, 'S', SORTIDA, e.on, cues[e.on].lon_cua, t);
+                e = crea_esdev(SORTIDA, ta+t, e.on);
+                posa_agenda(ta, e);
+            }else{
+                posa_caixa(&cues[e.on], 0);
+            }
+            break;
+        case TANCAR:
+            bn = 0;
+            break;
+        default:
+            fprintf(ofile,"ERROR: esdeveniment desconegut %d\n",e.que);
+            bolca_traca(TRACAFILENAME);
+            ret = -1;
+            break;
+    }// switch
+
+    s->ta = ta;
+    s->bn = bn;
+    s->it = it;
+    return (ret);
+} // tracta_esdev
+
+// Executa una replicacio de la simulacio amb ntc caixers i acumula les
+// estadistiques a sts (ja inicialitzat amb init_stats). El generador
+// aleatori del fil s'ha d'haver inicialitzat abans (ini_alea).
+// Retorna 0 si acaba be i -1 si troba un esdeveniment desconegut.
+int simula(int ntc, sstats *sts){
+    esdev e;
+    ssim s;
+    int ret = 0;
+
+    if(motor_processos)
+        return(simula_processos(ntc, sts));
+    if(fitxer_continua != NULL){
+        // Continua la simulacio desada: agenda, cues, estadistiques i generador
+        s.cues = NULL;
+        s.it = 0;
+        if(carrega_punt(fitxer_continua, &s.ta, &s.bn, &s.cues, ntc, sts) != 0)
+            ERROR((ofile, "ERROR: no es pot recuperar el punt de control %s\n", fitxer_continua));
+        if(llavor_continua != 0)
+            ini_alea(llavor_continua, 0);
+    }else
+        ini_simulacio(&s, ntc);
+    
+    while (ret == 0 && primer_agenda(&e) != 0){
+        if(temps_punt >= 0 && e.quan > temps_punt){
+            // Punt de control: l'estat despres de tots els events fins a temps_punt
+            if(desa_punt(fitxer_punt, s.ta, s.bn, s.cues, ntc, sts) != 0)
+                ERROR((ofile, "ERROR: no es pot desar el punt de control a %s\n", fitxer_punt));
+            fprintf(ofile, "Punt de control a %.2f desat a %s\n", s.ta, fitxer_punt);
+            break;
+        }
+        treu_agenda(s.ta, &e);
+        if(bolca_demanat){
+            bolca_demanat = 0;
+            bolca_traca(TRACAFILENAME);
+        }
+        ret = tracta_esdev(&s, e, ntc, sts);
+        TELEMETRIA(s.ta, s.cues, ntc, sts);
+    }// while
+    
+    // Temps de cada cua amb la longitud final fins a l'ultim event
+    actualitzar_stats_cua(s.cues, ntc, s.ta, sts);
+    publica_telemetria(s.ta, s.cues, ntc, sts, 1);
+    tanca_mser(sts);
+    elim_cues(s.cues, ntc);
+    allibera_agenda();
+    return (ret);
+} // simula
+
+// Amb SEV_SENSE_MAIN el motor es compila sense la linia de comandes (pels
+// programes que el fan servir directament, com el benchmark bench/sim_bench.c)
+#ifndef SEV_SENSE_MAIN
+// Llegeix els parametres de la linia de comandes:
+//   -n ntc   nombre total de caixers (si no es dona, es pregunta)
+//   -r R     nombre de replicacions independents (1 per defecte)
+//   -j fils  fils per executar les replicacions (per defecte, tots els nuclis)
+//   -s llavor llavor del generador (RANSEED per defecte, 0 aleatoria)
+//   -p lps   motor paral·lel conservador amb lps processos logics (0 = sequencial)
+//   -a temps temps mig entre arribades (ARRIVAL per defecte)
+//   -f rapids caixers rapids (N_RAPIDS per defecte)
+//   -e pol   politica d'encaminament: jsq (defecte), jsqd, rr o lwl
+//   -d d     cues mostrejades per jsqd (ENC_D per defecte)
+//   -m       trunca l'escalfament amb MSER-5 (motor sequencial i replicacions)
+//   -c temps desa un punt de control a l'instant temps i acaba
+//   -w fitxer fitxer del punt de control (PUNTFILENAME per defecte)
+//   -x fitxer continua la simulacio desada al fitxer (amb -s, amb una llavor nova)
+//   -o fitxer registre binari per columnes dels clients atesos (motor sequencial)
+//   -i       model escrit amb processos en lloc del switch d'events (sense -p, -c ni -x)
+//   -t fitxer arribades, articles i serveis d'un CSV de tiquets (sense -r, -p, -c ni -x)
+//   -q fraccio fraccio de clients rapids (FRAC_RAPIDS per defecte)
+//   -z objectiu busca caixers, rapids i fraccio amb menys personal (fins a -n) que
+//            compleixen mitjana:T o p95:T sobre el temps de cua (sense -r, -p, -c, -x, -o ni -t)
+//   -k K     probabilitat que una cua arribi a K clients esperant, per divisio (amb -r,
+//            trajectories arrel; sense -p, -c, -x, -o, -t, -i, -m ni -z)
+//   -v       temps de cua amb una cua M/M/c a l'ombra com a variable de control (amb
+//            -r 3 o mes; sense -p, -t, -k ni -z)
+//   -l fitxer arribades de Poisson amb la taxa del perfil del fitxer en lloc de -a
+//            (veure perfil.h; sense -t ni -v)
+//   -g segment publica l'estat periodicament al segment de memoria compartida
+//            (es pot seguir amb supermon; sense -r, -p, -k ni -z)
+static void input_parameters(int argc, char **argv, int *ntc, int *nrep, int *nfils, long int *llavor, int *nlps){
+    int opt;
+
+    while((opt = getopt(argc, argv, "n:r:j:s:p:a:f:e:d:mc:w:x:o:it:q:z:k:vl:g:")) != -1){
+        switch(opt){
+            case 'n': *ntc    = atoi(optarg); break;
+            case 'r': *nrep   = atoi(optarg); break;
+            case 'j': *nfils  = atoi(optarg); break;
+            case 's': *llavor = atol(optarg); llavor_donada = 1; break;
+            case 'p': *nlps   = atoi(optarg); break;
+            case 'a': temps_arribada = atof(optarg); break;
+            case 'f': n_rapids = atoi(optarg); break;
+            case 'e':
+                politica = politica_encaminament(optarg);
+                if(politica == NA){
+                    fprintf(stderr, "ERROR: politica d'encaminament desconeguda %s (jsq, jsqd, rr, lwl)\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'd': enc_d = atoi(optarg); break;
+            case 'm': escalfament = 1; break;
+            case 'c': temps_punt = atof(optarg); break;
+            case 'w': fitxer_punt = optarg; break;
+            case 'x': fitxer_continua = optarg; break;
+            case 'o': fitxer_registre = optarg; break;
+            case 'i': motor_processos = 1; break;
+            case 't': fitxer_tiquets = optarg; break;
+            case 'q': fraccio_rapids = atof(optarg); break;
+            case 'k': capacitat = atoi(optarg); break;
+            case 'v': control_mmc = 1; break;
+            case 'l': fitxer_perfil = optarg; break;
+            case 'g': segment_telemetria = optarg; break;
+            case 'z':
+                if(llegeix_objectiu(optarg, &mesura_objectiu, &valor_objectiu) != 0){
+                    fprintf(stderr, "ERROR: objectiu %s no valid (mitjana:T o p95:T, T > 0)\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                optimitzar = 1;
+                break;
+            default:
+                fprintf(stderr, "Use: %s [-n caixers] [-r replicacions] [-j fils] [-s llavor] [-p lps] [-a arribada] [-f rapids] [-e politica] [-d d] [-m] [-c temps] [-w fitxer] [-x fitxer] [-o fitxer] [-i] [-t fitxer] [-q fraccio] [-z objectiu] [-k K] [-v] [-l fitxer] [-g segment]\n", argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if(temps_arribada <= 0 || n_rapids < 1 || enc_d < 1){
+        fprintf(stderr, "ERROR: el temps entre arribades, els caixers rapids i d han de ser positius\n");
+        exit(EXIT_FAILURE);
+    }
+    if((temps_punt >= 0 || fitxer_continua != NULL) && (*nrep > 1 || *nlps > 0)){
+        fprintf(stderr, "ERROR: els punts de control nomes son pel motor sequencial (sense -r ni -p)\n");
+        exit(EXIT_FAILURE);
+    }
+    if(fitxer_registre != NULL && (*nrep > 1 || *nlps > 0)){
+        fprintf(stderr, "ERROR: el registre de clients nomes es pel motor sequencial (sense -r ni -p)\n");
+        exit(EXIT_FAILURE);
+    }
+    if(escalfament && (*nlps > 0 || temps_punt >= 0 || fitxer_continua != NULL)){
+        fprintf(stderr, "ERROR: -m no es pot fer servir amb -p, -c ni -x\n");
+        exit(EXIT_FAILURE);
+    }
+    if(motor_processos && (*nlps > 0 || temps_punt >= 0 || fitxer_continua != NULL)){
+        fprintf(stderr, "ERROR: -i no es pot fer servir amb -p, -c ni -x\n");
+        exit(EXIT_FAILURE);
+    }
+    if(fraccio_rapids < 0 || fraccio_rapids > 1){
+        fprintf(stderr, "ERROR: la fraccio de clients rapids ha d'estar entre 0 i 1\n");
+        exit(EXIT_FAILURE);
+    }
+    if(optimitzar && (*nrep > 1 || *nlps > 0 || temps_punt >= 0 || fitxer_continua != NULL
+                      || fitxer_registre != NULL || fitxer_tiquets != NULL)){
+        fprintf(stderr, "ERROR: -z no es pot fer servir amb -r, -p, -c, -x, -o ni -t\n");
+        exit(EXIT_FAILURE);
+    }
+    if(capacitat < 0 || (capacitat > 0 && (*nlps > 0 || temps_punt >= 0 || fitxer_continua != NULL
+                         || fitxer_registre != NULL || fitxer_tiquets != NULL || motor_processos
+                         || escalfament || optimitzar))){
+        fprintf(stderr, "ERROR: -k K (K > 0) no es pot fer servir amb -p, -c, -x, -o, -t, -i, -m ni -z\n");
+        exit(EXIT_FAILURE);
+    }
+    if(control_mmc && (*nrep < 3 || *nlps > 0 || fitxer_tiquets != NULL || capacitat > 0 || optimitzar)){
+        fprintf(stderr, "ERROR: -v necessita -r 3 o mes i no es pot fer servir amb -p, -t, -k ni -z\n");
+        exit(EXIT_FAILURE);
+    }
+    if(segment_telemetria != NULL && (*nrep > 1 || *nlps > 0 || capacitat > 0 || optimitzar)){
+        fprintf(stderr, "ERROR: -g no es pot fer servir amb -r, -p, -k ni -z\n");
+        exit(EXIT_FAILURE);
+    }
+    if(fitxer_perfil != NULL && (fitxer_tiquets != NULL || control_mmc)){
+        fprintf(stderr, "ERROR: -l no es pot fer servir amb -t ni -v\n");
+        exit(EXIT_FAILURE);
+    }
+    if(fitxer_tiquets != NULL && (*nrep > 1 || *nlps > 0 || temps_punt >= 0 || fitxer_continua != NULL)){
+        fprintf(stderr, "ERROR: -t no es pot fer servir amb -r, -p, -c ni -x\n");
+        exit(EXIT_FAILURE);
+    }
+} // input_parameters
+
+int main(int argc, char **argv) {
+    int ntc = 0;    // nombre total de caixers
+    int nrep = 1;   // nombre de replicacions
+    int nfils = 0;  // fils de treball (0 = nombre de nuclis)
+    int nlps = 0;   // processos logics del motor paral·lel (0 = sequencial)
+    int ret;
     char *filename = OUTFILENAME;
     long int llavor = RANSEED;      //Inicialitzar generador numeros aleatoris
  
+    input_parameters(argc, argv, &ntc, &nrep, &nfils, &llavor, &nlps);
+
     system("mkdir -p log");
     ofile = fopen(filename, "w");
     if(ofile == NULL){
@@ -49,161 +389,85 @@ int main(void) {
     if(llavor == 0){  // Zero for random start 
         llavor = time(0); 
     }
-    srand(llavor);    
+    if(fitxer_continua != NULL && llavor_donada)
+        llavor_continua = llavor;
     
-    puts("Nombre total de caixers?");
-    scanf("%d", &ntc);
-    printf("See results of execution in file: %s\n", OUTFILENAME);     
-    
-    print_configuracio(llavor, ntc);
-    
-    ini_agenda(N);
-    crea_cues(&cues, CUA_MAX, ntc);
-    init_stats(&sts, ntc);
-
-    //for(q = 0; q < ntc; q++){
-        e = crea_esdev(OBRIR, OBRIRTIME, NA);
-        posa_agenda(ta, e);
-    //}
-    // Tancar fa referència a tancar supermercat i no una caixa en concret
-    e = crea_esdev(TANCAR, TANCARTIME, NA);
-    posa_agenda(ta, e);
+    // Traces: categories en execucio (SEV_TRACA), bolcat amb SIGUSR1
+    ini_traca(getenv("SEV_TRACA"));
+#ifdef SIGUSR1
+    signal(SIGUSR1, demana_bolcat);
+#endif
 
-    bn = 0;
-    // caixa = 0; es fa dins de crea_cues
-    //nca = 0;
-    tmax = 0.0;
+    if(ntc <= 0){
+        puts("Nombre total de caixers?");
+        scanf("%d", &ntc);
+    }
+    // Els caixers lents son n_rapids..ntc-1: n'hi ha d'haver almenys un
+    // (l'optimitzador tria els rapids de cada configuracio)
+    if(!optimitzar && (ntc <= 0 || n_rapids >= ntc)){
+        fprintf(stderr, "ERROR: calen mes caixers (%d) que caixers rapids (%d)\n", ntc, n_rapids);
+        exit(EXIT_FAILURE);
+    }
+    printf("See results of execution in file: %s\n", OUTFILENAME);     
     
-    while (treu_agenda(ta, &e) != 0){
-        
-        switch (e.que){
-            case OBRIR:
-                bn = 1;
-                //caixa = 0;
-                e.on = NA;
-                t = expo(ARRIVAL); // ARRIVAL/ntc
-#if (DEBUGalea == 1)      
-                fprintf(ofile, " utilitzat per la seguent arribada a %lf cua %d\n",
-                        t, e.on);
-#endif
-                e = crea_esdev(ARRIBADA, t, e.on);
-                posa_agenda(ta, e);
-                break;
-            case ARRIBADA:
-                if(bn == 1){
-                    tant = ta;
-                    ta = e.quan;
-                    actualitzar_stats_cua(cues, ntc, tant, ta, &sts, MAXQUHIST);
-                    // Decideix si el client es ràpid o lent (30% rapids)
-                    int esRapid = (rand() % 100 < 30) ? 1 : 0;
-                    if(esRapid){
-                        //client cua ràpida
-                        e.on = primer_caixer_buit(cues, 0, N_RAPIDS -1);
-                        if (e.on != NA){
-                            cues[e.on].caixa = 1;
-                            t = 1 + expo(SERVICE);
-                            inc_stats(sts.dshist, e.on, (int)round(t), ntc, MAXDELHIST);
-                            e = crea_esdev(SORTIDA, ta+t, e.on);
-                            posa_agenda(ta, e);
-                        }else{
-                            // posar a la cua més curta de les ràpides
-                            c.on = cua_mes_curta(cues, 0, N_RAPIDS-1);
-                            c.tar = ta;
-                            c.tse = 0;
-                            j = posa_cua(&cues[c.on], ta, c);
-                            if(j == 0){
-                                puts("ERROR: cua ràpida massa petita");
-                                exit(0);
-
-                            }
-                        }
-                    
-                    }else{ 
-                        // client a la cua lenta 
-                        e.on = primer_caixer_buit(cues, N_RAPIDS, ntc-1);
-                        if (e.on != NA){
-                            cues[e.on].caixa = 1;
-                            t = 1 + expo(SERVICE);                             
-#if (DEBUGalea == 1)
-                        fprintf(ofile, " utilitzat pel servei a %lf cua %d\n", 
-                                t, e.on);
-#endif
-                            inc_stats(sts.dshist, e.on, (int)round(t), ntc, MAXDELHIST);
-#if DEBUGserv == 1    
-                        fprintf(ofile,"%.4lf TEMPS servei %.4lf: ARRIBADA %.4lf SORTIDA %.4lf\n", ta, t, e.quan,ta+t);
-                        fflush(ofile);
-#endif
-                            e = crea_esdev(SORTIDA, ta+t, e.on);
-                            posa_agenda(ta, e);
-                        }else{ // posar element a la cua d'espera
-                            c.on = cua_mes_curta(cues, N_RAPIDS, ntc-1);                         
-                            c.tar = ta;
-                            c.tse = 0; //??
-                            //c.on = cua_mes_curta(cues, ntc); 
-                            j = posa_cua(&cues[c.on], ta, c);
-                            if(j == 0){
-                                puts("ERROR: cua massa petita");
-                                exit(0);
-                            }
-                        }
-                    }//else
-                    // Decidir la seguent arribada
-                    t = ta + expo(ARRIVAL);// ARRIVAL/ntc
-                    e.on = NA;
-#if (DEBUGalea == 1)
-                    fprintf(ofile, " utilitzat per la seguent arribada a %lf cua %d \n", 
-                            t, e.on);
-#endif
-                    e = crea_esdev(ARRIBADA, t, e.on);
-                    posa_agenda(ta, e);
-                }//bn==1
-                break;
-            case SORTIDA:
-                inc_stats(&sts.nca, e.on, NA, ntc, NA);
-                tant = ta;
-                ta = e.quan;
-                actualitzar_stats_cua(cues, ntc, tant, ta, &sts, MAXQUHIST);
-                j  = treu_cua(&cues[e.on], ta, &c);
-                if (j != 0){
-                    t = e.quan - c.tar;
-                    inc_stats(sts.dqhist, e.on, (int)round(t), ntc, MAXDELHIST);
-#if DEBUGserv == 1                                            
-                    fprintf(ofile,"%.4lf Cua %d TEMPS total d'espera a la cua %.4lf (%3d)\n", ta, e.on, t, (int)round(t));
-                    //print_hist(ofile, sts.dhist[e.on], MAXDELHIST, "", MAXPRINTCOL);                        
-                    fflush(ofile);
-#endif
-                    t = 1+expo(SERVICE);                    
-#if (DEBUGalea == 1)
-                    fprintf(ofile, " utilitzat pel temps de servei %lf cua %d\n", 
-                            t, e.on);
-#endif
-                    c.tse = t;
-                    inc_stats(sts.dshist, e.on, (int)round(t), ntc, MAXDELHIST);
-                    inc_stats(sts.dthist, e.on, (int)round((e.quan-c.tar)+c.tse), ntc, MAXDELHIST);
-#if DEBUGserv == 1                               
-                    fprintf(ofile,"%.4lf TEMPS SERVEI %.4lf: ARRIBADA %.4lf SORTIDA %.4lf\n", ta, t, c.tar,ta+t);
-                    fflush(ofile);
-#endif
-                    e = crea_esdev(SORTIDA, ta+t, e.on);
-                    posa_agenda(ta, e);
-                }else{
-                    cues[e.on].caixa = 0;
-                }
-                break;
-            case TANCAR:
-                bn = 0;
-                break;
-            default:
-                fprintf(ofile,"ERROR: esdeveniment desconegut %d\n",e.que);
-                return (-1);
-        }// switch
-    }// while
+    // Sense -s, la continuacio no fa servir cap llavor sino el generador desat
+    print_configuracio((fitxer_continua != NULL && !llavor_donada) ? 0 : llavor, ntc);
+    if(fitxer_continua != NULL)
+        fprintf(ofile, "Continua del punt de control %s%s\n\n", fitxer_continua,
+                llavor_continua != 0 ? " amb la llavor nova" : "");
+    if(fitxer_registre != NULL){
+        if(obre_registre(fitxer_registre) != 0)
+            ERROR((ofile, "ERROR: no es pot crear el registre de clients %s\n", fitxer_registre));
+        fprintf(ofile, "Registre de clients a %s\n\n", fitxer_registre);
+    }
+    if(fitxer_tiquets != NULL){
+        if(obre_tiquets(fitxer_tiquets) != 0)
+            ERROR((ofile, "ERROR: no es poden llegir els tiquets %s\n", fitxer_tiquets));
+        fprintf(ofile, "Arribades dels tiquets %s: %lld clients fins a %.1f (tanca en acabar els tiquets)\n\n",
+                fitxer_tiquets, n_tiquets, tiquets[n_tiquets - 1].temps);
+    }
+    if(fitxer_perfil != NULL){
+        if(llegeix_perfil(fitxer_perfil) != 0)
+            ERROR((ofile, "ERROR: no es pot llegir el perfil d'arribades %s\n", fitxer_perfil));
+        fprintf(ofile, "Arribades amb el perfil %s: %.1f clients esperats fins a tancar\n\n",
+                fitxer_perfil, clients_perfil(OBRIRTIME, TANCARTIME));
+    }
+    if(segment_telemetria != NULL){
+        if(obre_telemetria(segment_telemetria, ntc) != 0)
+            ERROR((ofile, "ERROR: no es pot crear el segment de telemetria %s\n", segment_telemetria));
+        fprintf(ofile, "Telemetria cada %lld events al segment %s\n\n", telemetria_periode, segment_telemetria);
+    }
     
-    // Prints arguments
-    collect_stats(sts, ntc); 
-    free_stats(sts, ntc);
+    if(capacitat > 0){
+        ret = executa_restart(ntc, capacitat, nrep > 1 ? nrep : RSTARRELS, llavor);
+    }else if(optimitzar){
+        ret = optimitza(ntc, nfils, llavor, mesura_objectiu, valor_objectiu);
+    }else if(nrep > 1){
+        ret = executa_replicacions(ntc, nrep, nfils, llavor);
+    }else{
+        ini_alea(llavor, 0);
+        init_stats(&sts, ntc);
+        if(escalfament)
+            ini_mser(&sts);
+        if(nlps > 0)
+            ret = simula_pdes(ntc, nlps, &sts);
+        else
+            ret = simula(ntc, &sts);
+        // Prints arguments
+        collect_stats(sts, ntc); 
+        free_stats(sts, ntc);
+    }
+    if(tanca_registre() != 0)
+        ERROR((ofile, "ERROR: no es pot acabar d'escriure el registre de clients %s\n", fitxer_registre));
+    if(getenv("SEV_BOLCA") != NULL && !strcmp(getenv("SEV_BOLCA"), "1"))
+        bolca_traca(TRACAFILENAME);
+    tanca_tiquets();
+    allibera_perfil();
+    tanca_telemetria();
+    allibera_traca();
+    allibera_alea();
     
-    return (0); 
+    return (ret); 
 
 #if 0      // test queue
     c = crea_element_cua(2.1);
@@ -234,3 +498,4 @@ int main(void) {
 #endif
  
 }
+#endif // SEV_SENSE_MAIN
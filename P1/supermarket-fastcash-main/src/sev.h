@@ -26,19 +26,31 @@
 #define SERVICE       60     // Temps mig de servei
 
 /******  Dimensions dels Vectors *********/
-#define CUA_MAX        10    // nombre maxim elements a la cua
-#define N              10     // Nombre maxim d'events pendents d'executar (a function of ntc)
+#define CUA_MAX        10    // longitud de cua prevista (index i histogrames creixen sota demanda)
+#define BLOCCUA        8     // elements per bloc de cua
+#define POOLBLOCS      32    // blocs que es reserven de cop quan la reserva es buida
+#define N              10     // Capacitat inicial de l'agenda d'events (creix sota demanda)
 
-#define MAXQUHIST      5000    // Dimension of the queueing histogram array stats
-#define MAXDELHIST     50000  // Dimension of the delay histogram array statistics
+#define MAXQUHIST      (CUA_MAX + 1) // Initial dimension of the queueing histogram rows (grow on demand)
+#define HDRBITS        8      // Precision of the delay histograms: relative error < 2^-HDRBITS
+#define HDRRES         0.01   // Resolution of the delay histograms (time units)
 
-// Configuració pel seguiment de l'execució (Debugging), banderas : 0=NO, 1=SI
-#define DEBUGserv      1      // Bandera per fer seguiment del servei
-#define DEBUGagenda    1      // Bandera per fer seguiment de l'agenda
-#define DEBUGcua       1      // Bandera per fer seguiment de la cua
-#define DEBUGquinaCua  1      // Bandera per fer seguiment per decidir la cua on posar clients
-#define DEBUGalea      1      // Visualitza els streams aleatoris, desactivar totes les altres per utilitzar aquesta
-#define anyDEBUG       (DEBUGserv + DEBUGagenda + DEBUGcua + DEBUGquinaCua + DEBUGalea) 
+// Seguiment de l'execució (Debugging): traces binàries en un buffer circular
+// (veure traca.h). Les categories es trien en execució amb la variable
+// d'entorn SEV_TRACA (p.ex. SEV_TRACA=serv,cua; "tot" per defecte, "cap" cap).
+// El buffer s'escriu a TRACAFILENAME si hi ha un ERROR, si SEV_BOLCA=1 en
+// acabar, o quan el procés rep SIGUSR1. Es llegeix amb tools/decodetraca.
+#define TRACAFILENAME "log/traca.bin" // Nom del fitxer on es bolquen les traces
+
+// Punts de control (punt.c): -c temps desa l'estat a PUNTFILENAME (o al
+// fitxer de -w) i acaba; -x fitxer continua una simulacio desada.
+#define PUNTFILENAME  "log/punt.bin"  // Nom per defecte del fitxer del punt de control
+
+// Registre de clients (registre.c): -o fitxer escriu les dades de cada client
+// ates en binari per columnes (veure registre.h), sense passar per text.
+
+// Tiquets de caixa (tiquets.c): -t fitxer.csv treu les arribades, la classe i
+// el servei d'un registre real; el CSV es converteix un cop a fitxer.csv.bin.
 
 //--------------------- Constants de programació ---------------------
 #define NA            -1   // Value not applicable
@@ -48,15 +60,35 @@
 #define ARRIBADA  'A'
 #define SORTIDA   'S'
 #define TANCAR    'T'
+#define PROCES    'P'   // reactivacio d'un proces (proces.h), on = id del proces
 #define N_RAPIDS 2
+#define FRAC_RAPIDS 0.30   // fraccio de clients rapids
+
+// Politiques d'encaminament dels clients a les cues (cua.c, opcio -e)
+#define ENC_JSQ    0   // primer caixer lliure o cua mes curta
+#define ENC_JSQD   1   // la mes curta de d cues triades a l'atzar
+#define ENC_RR     2   // torn rotatiu
+#define ENC_LWL    3   // menys treball pendent
+#define ENC_D      2   // cues mostrejades per ENC_JSQD
 
 extern FILE *ofile;              // Fitxer per debuggar
+extern float temps_arribada;     // Temps mig entre arribades (ARRIVAL, o l'opcio -a)
+// La configuracio dels caixers es propia de cada fil perque l'optimitzador
+// (optim.c) pugui simular configuracions diferents alhora; els fils de
+// treball copien la del fil principal abans de simular.
+extern _Thread_local int n_rapids;          // Caixers rapids (N_RAPIDS, o l'opcio -f)
+extern _Thread_local double fraccio_rapids; // Fraccio de clients rapids (FRAC_RAPIDS, o l'opcio -q)
+extern int politica;             // Politica d'encaminament (ENC_JSQ, o l'opcio -e)
+extern int enc_d;                // Cues mostrejades per ENC_JSQD (ENC_D, o l'opcio -d)
+extern int escalfament;          // Truncacio de l'escalfament amb MSER-5 (opcio -m)
+extern int control_mmc;          // Cua M/M/c a l'ombra com a variable de control (opcio -v)
 // Use ERROR when the print out informs of a problem in the program and it must abort but printing statistics before finishing
 // Use ERRORF when the print out informs of a problem in the program and it must abort without any stats printing
 // WARNING currently not used, but can be used to provide non-fatal errors in the program and the program can continue
 
 /* usage: ERROR(("Warning: Note the two brackets\n")) */
 #define ERROR(message)({fprintf(ofile,"\nERROOORRRRRRRRRR\n");fprintf message;\
+                        bolca_traca(TRACAFILENAME);\
                         printf("\nERROOORRRRRRRRRR see output file\n");exit(0);})
 
 #define WARNING(message1, message2) ({fprintf(ofile, message1,message2);})
@@ -68,19 +100,46 @@ typedef struct{
     float tar; // temps d'arribada a la cua
     float tse; // temps de servei
     int on;    // caixer
+    int lon;   // clients a la cua quan hi entra (registre de clients)
 }el_cua; 
 
+typedef struct sindex sindex; // Index de caixers lliures i longituds de cua (cua.c)
+typedef struct sbloc sbloc;   // Bloc d'elements d'una cua (cua.c)
+typedef struct spool spool;   // Reserva de blocs lliures d'un vector de cues (cua.c)
+
 typedef struct{
     int idcua;    // posició de la cua per debug
-    int max_cua;  // capacitat maxima d'elements a la cua
-    int ini_cua;  // Primer element de la cua
-    int fin_cua;  // ultim element de la cua
+    int ini_cua;  // Primer element de la cua (posicio dins del bloc cap)
+    int fin_cua;  // ultim element de la cua (posicio dins del bloc final)
     int lon_cua;  // Quantitat d'elements a la cua 
-    el_cua *elem; // Elements guardats a la cua
+    sbloc *cap;   // Bloc amb el primer element (NULL si la cua es buida)
+    sbloc *final; // Bloc amb l'ultim element
+    spool *pool;  // Reserva d'on surten els blocs (compartida pel vector)
     int caixa;    // Estat de la caixa: 
+    float fi_servei; // fi del servei en curs (si caixa == 1)
+    double treball;  // suma dels temps de servei dels clients a la cua
+    float tcanvi; // darrer canvi de longitud (estadistica de la cua)
+    sindex *index; // index del vector de cues (NULL si no en te)
 } scua;
 
+// Fluxos aleatoris independents (stochastic.c)
+#define ALEA_GENERAL   0   // drand() i expo()
+#define ALEA_ARRIBADES 1   // temps entre arribades
+#define ALEA_CLASSE    2   // client rapid o lent
+#define ALEA_ENCAMINA  3   // cues mostrejades per ENC_JSQD
+#define ALEA_SERVEI    4   // temps de servei: flux ALEA_SERVEI + caixer
+
 float expo(float m);
+double drand(void);
+double alea(int flux);
+float expo_flux(int flux, float m);
+float temps_servei(int caixer);
+void ini_alea(unsigned long long llavor, int flux);
+void allibera_alea(void);
+int desa_alea(FILE *f);
+int carrega_alea(FILE *f);
+
+#include "traca.h"
    
 #endif
 
@@ -10,13 +10,71 @@
 
 #include <time.h>
 #include <math.h>
+#include <string.h>
 #include "sev.h"
 #include "stats.h"
 #include "cua.h"
 
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
 FILE *ofile = NULL;
 long     start_stats;   // Time to start turning ON statistics gathering (end of warmup period)
 sstats   sts;           // Variable with ALL statistics
+float    temps_arribada = ARRIVAL; // Mean inter-arrival time (ARRIVAL or -a)
+_Thread_local int    n_rapids = N_RAPIDS;           // Number of fast cashiers (N_RAPIDS or -f), per thread
+_Thread_local double fraccio_rapids = FRAC_RAPIDS;  // Fraction of fast customers (FRAC_RAPIDS or -q), per thread
+int      politica = ENC_JSQ;       // Routing policy (ENC_JSQ or -e)
+int      enc_d = ENC_D;            // Lanes sampled by ENC_JSQD (ENC_D or -d)
+int      escalfament = 0;          // MSER-5 warm-up truncation (-m)
+int      control_mmc = 0;          // Shadow M/M/c queue as control variate (-v)
+
+// Statistics update held back while the warm-up is undecided
+typedef struct {
+    char  tipus;    // 'Q','S','T' delays, 'N' served client, 'L' queue length interval
+    int   c;        // cashier
+    int   lon;      // queue length ('L')
+    float t0;       // start of the interval ('L')
+    float t1;       // time of the update (end of the interval for 'L')
+    float valor;    // delay ('Q','S','T')
+}sobs;
+
+// MSER-5 warm-up detector. The queue delay of every customer (0 if served
+// at once) is averaged in batches of MSERBATCH. While the truncation point
+// is undecided every statistics update is logged; when it is decided the
+// updates after the truncation time are replayed and the rest dropped, and
+// from then on the batches are only counted.
+struct smser {
+    int     actiu;     // 1 while the warm-up is undecided
+    double *z;         // batch means [k] (freed when decided)
+    float  *tz;        // time of the last observation of each batch [k] (freed when decided)
+    int     k, maxk;   // batches completed and allocated
+    double  suma;      // sum of the current batch
+    int     n;         // observations in the current batch
+    sobs   *log;       // held back updates [nlog]
+    long    nlog, maxlog;
+    int     dant;      // truncation of the previous online check (NA none)
+    int     d;         // batches truncated
+    float   ttrunc;    // truncation time
+};
+
+static void free_mser(smser *m);
+
+// Shadow FIFO M/M/c queues, one per class of customers: the customers that
+// may go to the cashiers ini..fin are fed, with their arrival time and the
+// exponential part of their service time, to a pool of fin - ini + 1
+// servers. Each class is a thinning of the Poisson arrivals and the service
+// times are i.i.d. exponential whatever the routing, so every pool is
+// exactly an M/M/c started empty (espera_mmc).
+struct sombra {
+    int     c;       // servers of all the pools
+    double *lliure;  // min-heap of the times the servers of each pool ini..fin become free [c]
+    double  espera;  // sum of the waits
+    long    n;       // customers
+};
+
+static void free_ombra(sombra *o);
 
 // Returns the number of samples in the histogram
 long samples(long *h,long dimh){
@@ -68,6 +126,40 @@ double mean_hist(long *h,long dimh){
     return(m);
 } // mean_hist
 
+// Time-weighted histograms (h[i] = time spent with value i)
+
+// Computes the time-weighted mean of a time histogram
+double mean_thist(double *h, long dimh){
+    long i;
+    double m = 0.0, temps = 0.0;
+
+    for(i = 0; i < dimh; i++){
+        m += h[i] * i;
+        temps += h[i];
+    }
+    return(temps > 0 ? m / temps : 0.0);
+} // mean_thist
+
+// Computes the minimum value with time spent in a time histogram
+long min_thist(double *h, long dimh){
+    long i;
+
+    for(i = 0; i < dimh; i++){
+        if( h[i] != 0) return(i);
+    }
+    return(i);
+} // min_thist
+
+// Computes the maximum value with time spent in a time histogram
+long max_thist(double *h, long dimh){
+    long i;
+
+    for(i = dimh-1; i >= 0; i--){
+        if( h[i] != 0) return(i);
+    }
+    return(i);
+} // max_thist
+
 // Suma el contingut del vector
 long suma_vect(long *v,long dimh){
     long i;
@@ -134,6 +226,161 @@ void print_hist(FILE *ofile, long *v, long length, char *msg, int num_col){
     fflush(ofile);
 } // print_hist
 
+// Position of the most significant bit of x (x != 0)
+static int msb(unsigned long long x){
+#if defined(__GNUC__) || defined(__clang__)
+    return(63 - __builtin_clzll(x));
+#else
+    int k = 0;
+    while(x >>= 1)
+        k++;
+    return(k);
+#endif
+} // msb
+
+// Bucket of the value u (in resolution units) in a log-linear histogram
+static int index_hdr(int bits, unsigned long long u){
+    int b;
+
+    if(u < (1ULL << bits))
+        return((int) u);
+    b = msb(u) - bits + 1;
+    return((1 << bits) + (b - 1) * (1 << (bits - 1)) + (int)((u >> b) - (1ULL << (bits - 1))));
+} // index_hdr
+
+// Lowest value (in resolution units) and width of bucket i
+static unsigned long long base_hdr(int bits, int i, unsigned long long *width){
+    int j, b, half = 1 << (bits - 1);
+
+    if(i < (1 << bits)){
+        *width = 1;
+        return((unsigned long long) i);
+    }
+    j = i - (1 << bits);
+    b = j / half + 1;
+    *width = 1ULL << b;
+    return((unsigned long long)(half + j % half) << b);
+} // base_hdr
+
+// Init an empty log-linear histogram with the given precision
+void init_hdr(shdr *h, int bits){
+    h->n = NULL;
+    h->nb = 0;
+    h->bits = bits;
+    h->samples = 0;
+    h->sum = 0.0;
+    h->min = 0.0;
+    h->max = 0.0;
+} // init_hdr
+
+void free_hdr(shdr *h){
+    free(h->n);
+    h->n = NULL;
+    h->nb = 0;
+} // free_hdr
+
+// Makes room for buckets 0..i
+static void grow_hdr(shdr *h, int i){
+    int nb = (h->nb == 0) ? (1 << h->bits) : h->nb;
+
+    while(nb <= i)
+        nb *= 2;
+    h->n = (long *) realloc(h->n, nb * sizeof(long));
+    if(h->n == NULL)
+        ERROR((ofile,"ERROR: allocating memory in grow_hdr\n"));
+    memset(h->n + h->nb, 0, (nb - h->nb) * sizeof(long));
+    h->nb = nb;
+} // grow_hdr
+
+// Records the value x. Negative values count as 0 and values too large for
+// 62 bits in resolution units go to the last bucket (min/max stay exact).
+void inc_hdr(shdr *h, double x){
+    double u;
+    int i;
+
+    if(!(x > 0))
+        x = 0;
+    u = x / HDRRES + 0.5;
+    if(u > 4.0e18)
+        u = 4.0e18;
+    i = index_hdr(h->bits, (unsigned long long) u);
+    if(i >= h->nb)
+        grow_hdr(h, i);
+    h->n[i]++;
+    if(h->samples == 0 || x < h->min) h->min = x;
+    if(h->samples == 0 || x > h->max) h->max = x;
+    h->samples++;
+    h->sum += x;
+} // inc_hdr
+
+// Adds the histogram src to dst (both with the same precision)
+void suma_hdr(shdr *dst, shdr *src){
+    int i;
+
+    if(dst->bits != src->bits)
+        ERROR((ofile,"ERROR suma_hdr: precisions %d and %d\n", dst->bits, src->bits));
+    if(src->samples == 0)
+        return;
+    if(src->nb > dst->nb)
+        grow_hdr(dst, src->nb - 1);
+    for(i = 0; i < src->nb; i++)
+        dst->n[i] += src->n[i];
+    if(dst->samples == 0 || src->min < dst->min) dst->min = src->min;
+    if(dst->samples == 0 || src->max > dst->max) dst->max = src->max;
+    dst->samples += src->samples;
+    dst->sum += src->sum;
+} // suma_hdr
+
+double mean_hdr(shdr *h){
+    return(h->samples > 0 ? h->sum / h->samples : 0.0);
+} // mean_hdr
+
+// Value below which are the p percent of the samples (middle of its bucket)
+double percentile_hdr(shdr *h, double p){
+    long acc = 0, rank;
+    int i;
+    unsigned long long lo, width;
+    double v;
+
+    if(h->samples == 0)
+        return(0.0);
+    rank = (long) ceil(p / 100.0 * h->samples);
+    if(rank < 1) rank = 1;
+    for(i = 0; i < h->nb; i++){
+        acc += h->n[i];
+        if(acc >= rank)
+            break;
+    }
+    lo = base_hdr(h->bits, i, &width);
+    v = (lo + (width - 1) / 2.0) * HDRRES;
+    if(v < h->min) v = h->min;
+    if(v > h->max) v = h->max;
+    return(v);
+} // percentile_hdr
+
+// Prints a log-linear histogram: summary and the non-empty buckets
+// (lower bound: count) with num_col buckets per line
+void print_hdr(FILE *ofile, shdr *h, char *msg, int num_col){
+    int i, col = 0;
+    unsigned long long lo, width;
+
+    fprintf(ofile, "%s", msg);
+    fprintf(ofile, " Mean: %.2lf, Samples: %ld,", mean_hdr(h), h->samples);
+    fprintf(ofile, " Min: %.2lf, Max %.2lf,", h->min, h->max);
+    fprintf(ofile, " P50: %.2lf, P90: %.2lf, P99: %.2lf\n",
+            percentile_hdr(h, 50), percentile_hdr(h, 90), percentile_hdr(h, 99));
+    for(i = 0; i < h->nb; i++){
+        if(h->n[i] == 0)
+            continue;
+        if(col++ % num_col == 0)
+            fprintf(ofile, "\n");
+        lo = base_hdr(h->bits, i, &width);
+        fprintf(ofile, "%9.2lf:%-5ld ", lo * HDRRES, h->n[i]);
+    }
+    fprintf(ofile, "\n\n");
+    fflush(ofile);
+} // print_hdr
+
 // Init of the statistics
 void init_stats(sstats *stats, int ntc){
     int h,i,j;
@@ -149,63 +396,77 @@ void init_stats(sstats *stats, int ntc){
         ERROR((ofile,"ERROR: allocating memory in init_stats\n"));
 #endif
     
-    sts.qhist = (long **) malloc(ntc * sizeof(long*));
-    if(sts.qhist == NULL )
+    sts.qhist = (double **) malloc(ntc * sizeof(double*));
+    sts.nqhist = (long *) malloc(ntc * sizeof(long));
+    if(sts.qhist == NULL || sts.nqhist == NULL)
         ERROR((ofile,"ERROR: allocating memory in init_stats\n"));
     for(j = 0; j < ntc; j++){                
-        sts.qhist[j]= (long *) calloc(MAXQUHIST, sizeof(long));        
+        sts.qhist[j]= (double *) calloc(MAXQUHIST, sizeof(double));        
         if(sts.qhist[j] == NULL )
             ERROR((ofile,"ERROR: allocating memory in init_stats\n"));
+        sts.nqhist[j] = MAXQUHIST;
     }
-    sts.dqhist = (long **) malloc(ntc * sizeof(long*));
-    if(sts.dqhist == NULL )
+    sts.dqhist = (shdr *) malloc(ntc * sizeof(shdr));
+    sts.dshist = (shdr *) malloc(ntc * sizeof(shdr));
+    sts.dthist = (shdr *) malloc(ntc * sizeof(shdr));
+    if(sts.dqhist == NULL || sts.dshist == NULL || sts.dthist == NULL)
         ERROR((ofile,"ERROR: allocating memory in init_stats\n"));
     for(j = 0; j < ntc; j++){
-        sts.dqhist[j]= (long *) calloc(MAXDELHIST, sizeof(long));
-        if(sts.dqhist[j] == NULL )
-            ERROR((ofile,"ERROR: allocating memory in init_stats\n"));    
+        init_hdr(&sts.dqhist[j], HDRBITS);
+        init_hdr(&sts.dshist[j], HDRBITS);
+        init_hdr(&sts.dthist[j], HDRBITS);
     }
-     
-    sts.dshist = (long **) malloc(ntc * sizeof(long*));
-    if(sts.dshist == NULL )
-        ERROR((ofile,"ERROR: allocating memory in init_stats\n"));
-    for(j = 0; j < ntc; j++){
-        sts.dshist[j]= (long *) calloc(MAXDELHIST, sizeof(long));
-        if(sts.dshist[j] == NULL )
-            ERROR((ofile,"ERROR: allocating memory in init_stats\n"));    
-    }  
-        
-    sts.dthist = (long **) malloc(ntc * sizeof(long*));
-    if(sts.dthist == NULL )
-        ERROR((ofile,"ERROR: allocating memory in init_stats\n"));
-    for(j = 0; j < ntc; j++){
-        sts.dthist[j]= (long *) calloc(MAXDELHIST, sizeof(long));
-        if(sts.dthist[j] == NULL )
-            ERROR((ofile,"ERROR: allocating memory in init_stats\n"));    
-    }  
+    sts.mser = NULL;
+    sts.ombra = NULL;
     sts.av_delay  = 0.0;
     sts.av_qu_len = 0.0; 
     *stats = sts;
 }// init_stats
 
+// Prints a time histogram of length length (in lines) with num_col numbers
+// with its time-weighted mean, the total time and a message given
+void print_thist(FILE *ofile, double *v, long length, char *msg, int num_col){
+    long i, max;
+    double temps = 0.0;
+
+    for(i = 0; i < length; i++)
+        temps += v[i];
+    fprintf(ofile, "%s", msg);
+    fprintf(ofile, " Mean: %.2lf, Time: %.2lf,", mean_thist(v,length), temps);
+    fprintf(ofile, " Min: %ld, Max %ld\n", min_thist(v,length), max_thist(v,length));
+    max = max_thist(v,length) + 1;
+    if(max < length - 1) max += 1; // want to visualize at least one zero.
+    for (i = 0; i < max; i++ ){
+        if(i % num_col == 0)
+            fprintf(ofile, "\n%3ld | ", i);
+        fprintf(ofile, "%8.1lf ", v[i]);
+    }
+    fprintf(ofile, "\n\n");
+    fflush(ofile);
+} // print_thist
+
 // Frees all dynamic memory allocated with init_stats
 void free_stats(sstats sts, int ntc){
      
     int h,i,j;
+    free(sts.nca);
     free(sts.gload);
     
     for(j = 0; j < ntc; j++)
         free(sts.qhist[j]);  
     free(sts.qhist);
+    free(sts.nqhist);
  
     for(j = 0; j < ntc; j++){
-        free(sts.dqhist[j]);  
-        free(sts.dshist[j]);  
-        free(sts.dthist[j]);  
+        free_hdr(&sts.dqhist[j]);  
+        free_hdr(&sts.dshist[j]);  
+        free_hdr(&sts.dthist[j]);  
     }       
     free(sts.dqhist);
     free(sts.dshist);
     free(sts.dthist);
+    free_mser(sts.mser);
+    free_ombra(sts.ombra);
      
 } // free_stats
 
@@ -230,6 +491,502 @@ long *sum_stn_hists(long *sum, long **h, long dimh, int numstns){
     return(sum);
 } // sum_stn_hists
 
+// Computes the mean of the delay histograms of all the stations together
+double mean_stn_hdr(shdr *h, int numstns){
+    int s;
+    long n = 0;
+    double m = 0.0;
+
+    for(s = 0; s < numstns; s++){
+        m += h[s].sum;
+        n += h[s].samples;
+    }
+    return(n > 0 ? m / n : 0.0);
+} // mean_stn_hdr
+
+// Grows the queue length histogram of cashier c so that length l fits
+// (at least doubling it). New positions start at zero.
+static void grow_qhist(sstats *sts, int c, long l){
+    long n = 2 * sts->nqhist[c], d;
+    double *v;
+
+    if(n <= l)
+        n = l + 1;
+    v = (double *) realloc(sts->qhist[c], n * sizeof(double));
+    if(v == NULL)
+        ERROR((ofile,"ERROR: allocating memory in grow_qhist\n"));
+    for(d = sts->nqhist[c]; d < n; d++)
+        v[d] = 0.0;
+    sts->qhist[c] = v;
+    sts->nqhist[c] = n;
+} // grow_qhist
+
+// Turns on the MSER-5 warm-up detector of sts (after init_stats)
+void ini_mser(sstats *sts){
+    smser *m = (smser *) calloc(1, sizeof(smser));
+
+    if(m == NULL)
+        ERROR((ofile,"ERROR: allocating memory in ini_mser\n"));
+    m->actiu = 1;
+    m->dant = NA;
+    sts->mser = m;
+} // ini_mser
+
+static void free_mser(smser *m){
+    if(m == NULL)
+        return;
+    free(m->z);
+    free(m->tz);
+    free(m->log);
+    free(m);
+} // free_mser
+
+// MSER statistic of the k batch means for every truncation d <= k/2:
+// MSER(d) = sum_{j>=d} (z_j - mean_d)^2 / (k-d)^2. Returns the d with the
+// minimum (the first one on ties). Cost O(k) with suffix sums.
+static int truncacio_mser(double *z, int k){
+    int j, d = 0;
+    double s = 0.0, q = 0.0, n, v, vmin = 0.0;
+
+    for(j = k - 1; j >= 0; j--){
+        s += z[j];
+        q += z[j] * z[j];
+        if(j <= k / 2){
+            n = k - j;
+            v = (q - s * s / n) / (n * n);
+            if(j == k / 2 || v <= vmin){
+                vmin = v;
+                d = j;
+            }
+        }
+    }
+    return(d);
+} // truncacio_mser
+
+// Applies one statistics update to the histograms of sts
+static void aplica_obs(sstats *sts, sobs *o){
+    switch(o->tipus){
+        case 'Q': inc_hdr(&sts->dqhist[o->c], o->valor); break;
+        case 'S': inc_hdr(&sts->dshist[o->c], o->valor); break;
+        case 'T': inc_hdr(&sts->dthist[o->c], o->valor); break;
+        case 'N': sts->nca[o->c]++; break;
+        case 'L':
+            if(o->lon >= sts->nqhist[o->c])
+                grow_qhist(sts, o->c, o->lon);
+            sts->qhist[o->c][o->lon] += (double) o->t1 - (double) o->t0;
+            break;
+    }
+} // aplica_obs
+
+// Ends the warm-up dropping the first d batches: the logged updates after
+// their last observation are applied (queue length intervals clipped)
+static void decideix_mser(sstats *sts, int d){
+    smser *m = sts->mser;
+    sobs *o;
+    long i;
+
+    m->d = d;
+    m->ttrunc = (d > 0) ? m->tz[d - 1] : 0.0;
+    for(i = 0; i < m->nlog; i++){
+        o = &m->log[i];
+        if(o->tipus == 'L'){
+            if(o->t0 < m->ttrunc)
+                o->t0 = m->ttrunc;
+            if(o->t1 > o->t0)
+                aplica_obs(sts, o);
+        }else if(o->t1 > m->ttrunc || d == 0)
+            aplica_obs(sts, o);
+    }
+    free(m->log);
+    free(m->z);
+    free(m->tz);
+    m->log = NULL;
+    m->z = NULL;
+    m->tz = NULL;
+    m->nlog = m->maxlog = 0;
+    m->maxk = 0;
+    m->actiu = 0;
+} // decideix_mser
+
+// Holds back an update until the warm-up is decided
+static void guarda_obs(smser *m, char tipus, int c, int lon, float t0, float t1, float valor){
+    sobs *o;
+
+    if(m->nlog == m->maxlog){
+        m->maxlog = (m->maxlog > 0) ? 2 * m->maxlog : 1024;
+        o = (sobs *) realloc(m->log, m->maxlog * sizeof(sobs));
+        if(o == NULL)
+            ERROR((ofile,"ERROR: allocating memory in guarda_obs\n"));
+        m->log = o;
+    }
+    o = &m->log[m->nlog++];
+    o->tipus = tipus;
+    o->c = c;
+    o->lon = lon;
+    o->t0 = t0;
+    o->t1 = t1;
+    o->valor = valor;
+} // guarda_obs
+
+// Adds a queue delay observation at time ta to the batches. The online rule
+// is checked when the number of batches is a power of two (amortised O(1)):
+// the warm-up ends once there are MSERKMIN batches and the MSER truncation
+// is in the first half and has not changed since the previous check. If it
+// has not ended at MSERKMAX batches the truncation is chosen with them, so
+// a non-stationary run does not hold back all its updates.
+static void obs_mser(sstats *sts, float ta, float tq){
+    smser *m = sts->mser;
+    int d;
+
+    if(!m->actiu){   // decided: the batches are only counted for the report
+        if(++m->n == MSERBATCH){
+            m->k++;
+            m->n = 0;
+        }
+        return;
+    }
+    m->suma += tq;
+    if(++m->n < MSERBATCH)
+        return;
+    if(m->k == m->maxk){
+        m->maxk = (m->maxk > 0) ? 2 * m->maxk : 64;
+        m->z = (double *) realloc(m->z, m->maxk * sizeof(double));
+        m->tz = (float *) realloc(m->tz, m->maxk * sizeof(float));
+        if(m->z == NULL || m->tz == NULL)
+            ERROR((ofile,"ERROR: allocating memory in obs_mser\n"));
+    }
+    m->z[m->k] = m->suma / MSERBATCH;
+    m->tz[m->k] = ta;
+    m->k++;
+    m->suma = 0.0;
+    m->n = 0;
+    if(m->k >= MSERKMIN / 2 && (m->k & (m->k - 1)) == 0){
+        d = truncacio_mser(m->z, m->k);
+        if(m->k >= MSERKMAX || (m->k >= MSERKMIN && d < m->k / 2 && d == m->dant))
+            decideix_mser(sts, d);
+        m->dant = d;
+    }
+} // obs_mser
+
+// Turns on the shadow M/M/c queues of sts with c servers in all (after init_stats)
+void ini_ombra(sstats *sts, int c){
+    sombra *o = (sombra *) calloc(1, sizeof(sombra));
+
+    if(o != NULL)
+        o->lliure = (double *) calloc(c, sizeof(double));
+    if(o == NULL || o->lliure == NULL)
+        ERROR((ofile,"ERROR: allocating memory in ini_ombra\n"));
+    o->c = c;
+    sts->ombra = o;
+} // ini_ombra
+
+static void free_ombra(sombra *o){
+    if(o == NULL)
+        return;
+    free(o->lliure);
+    free(o);
+} // free_ombra
+
+// A customer arrives at time ta with exponential service ts to the shadow
+// pool of the servers ini..fin: it takes the server that becomes free first
+// (FIFO), O(log c)
+void inc_ombra(sstats *sts, int ini, int fin, float ta, float ts){
+    sombra *o = sts->ombra;
+    double *h, w, v;
+    int i, f, c = fin - ini + 1;
+
+    if(o == NULL)
+        return;
+    h = o->lliure + ini;
+    w = (h[0] > ta) ? h[0] - ta : 0.0;
+    o->espera += w;
+    o->n++;
+    v = ta + w + ts;
+    for(i = 0; (f = 2 * i + 1) < c; i = f){   // sift down the new free time
+        if(f + 1 < c && h[f + 1] < h[f])
+            f++;
+        if(h[f] >= v)
+            break;
+        h[i] = h[f];
+    }
+    h[i] = v;
+} // inc_ombra
+
+// Sum of the waits in the shadow queues
+double espera_ombra(sstats *sts){
+    return(sts->ombra != NULL ? sts->ombra->espera : 0.0);
+} // espera_ombra
+
+// Expected sum of the waits of the customers arriving in [0, T) to an
+// M/M/c queue (arrival rate lambda, service rate mu) that starts empty.
+// By PASTA it is lambda * int_0^T sum_n P_n(t) w(n) dt, with w(n) =
+// (n - c + 1) / (c mu) the mean wait of an arrival that finds n customers.
+// The integral is computed by uniformization with rate L = lambda + c mu:
+// int_0^T P(t) dt = (1/L) sum_k P(Poisson(L T) > k) pi_k, pi_k = pi_0 D^k.
+// The state space is truncated far above what T allows to reach.
+double espera_mmc(double lambda, double mu, int c, double T){
+    double *pi, *nou, L = lambda + c * mu, LT, lp, cdf = 0, w, acc = 0, s;
+    int n, k, M;
+
+    LT = L * T;
+    M = c + (int) (lambda * T + 10 * sqrt(lambda * T + 1)) + 50;
+    pi = (double *) calloc(M + 1, sizeof(double));
+    nou = (double *) calloc(M + 1, sizeof(double));
+    if(pi == NULL || nou == NULL)
+        ERROR((ofile,"ERROR: allocating memory in espera_mmc\n"));
+    pi[0] = 1.0;
+    lp = -LT;   // log P(Poisson(LT) = k)
+    for(k = 0; k <= LT || exp(lp) > 1e-16; k++){
+        cdf += exp(lp);
+        s = 0.0;
+        for(n = c; n <= M; n++)
+            s += pi[n] * (n - c + 1);
+        w = s / (c * mu);
+        acc += w * ((cdf < 1.0) ? 1.0 - cdf : 0.0);
+        // pi_{k+1} = pi_k D, D = I + Q / L
+        for(n = 0; n <= M; n++){
+            nou[n] = pi[n] * (1.0 - ((n < M) ? lambda : 0.0) / L - ((n < c) ? n : c) * mu / L);
+            if(n > 0)
+                nou[n] += pi[n - 1] * lambda / L;
+            if(n < M)
+                nou[n] += pi[n + 1] * ((n + 1 < c) ? n + 1 : c) * mu / L;
+        }
+        memcpy(pi, nou, (M + 1) * sizeof(double));
+        lp += log(LT) - log(k + 1.0);
+    }
+    free(pi);
+    free(nou);
+    return(lambda * acc / L);
+} // espera_mmc
+
+// Ends the run for the warm-up detector: if the online rule has not
+// decided yet, the truncation is chosen with all the batches
+void tanca_mser(sstats *sts){
+    smser *m = sts->mser;
+
+    if(m != NULL && m->actiu)
+        decideix_mser(sts, truncacio_mser(m->z, m->k));
+} // tanca_mser
+
+// A customer leaves cashier c at time ta
+void inc_atesos(sstats *sts, int c, float ta){
+    if(sts->mser != NULL && sts->mser->actiu)
+        guarda_obs(sts->mser, 'N', c, 0, ta, ta, 0);
+    else
+        sts->nca[c]++;
+} // inc_atesos
+
+// A customer starts its service ts at cashier c at time ta. If it came from
+// the queue (de_cua) it has waited tq and its queue and total times are
+// also recorded. Every customer is an observation for the warm-up detector.
+void inc_servei(sstats *sts, int c, float ta, float tq, float ts, int de_cua){
+    smser *m = sts->mser;
+
+    if(m != NULL){
+        obs_mser(sts, ta, tq);
+        if(m->actiu){
+            if(de_cua){
+                guarda_obs(m, 'Q', c, 0, ta, ta, tq);
+                guarda_obs(m, 'T', c, 0, ta, ta, tq + ts);
+            }
+            guarda_obs(m, 'S', c, 0, ta, ta, ts);
+            return;
+        }
+    }
+    if(de_cua){
+        inc_hdr(&sts->dqhist[c], tq);
+        inc_hdr(&sts->dshist[c], ts);
+        inc_hdr(&sts->dthist[c], tq + ts);
+    }else
+        inc_hdr(&sts->dshist[c], ts);
+} // inc_servei
+
+// Writes a delay histogram to f (checkpoint). Returns 0 if ok, -1 if not
+static int desa_hdr(FILE *f, shdr *h){
+    int ok;
+
+    ok = fwrite(&h->nb, sizeof(h->nb), 1, f) == 1;
+    ok = ok && fwrite(&h->samples, sizeof(h->samples), 1, f) == 1;
+    ok = ok && fwrite(&h->sum, sizeof(h->sum), 1, f) == 1;
+    ok = ok && fwrite(&h->min, sizeof(h->min), 1, f) == 1;
+    ok = ok && fwrite(&h->max, sizeof(h->max), 1, f) == 1;
+    if(ok && h->nb > 0)
+        ok = fwrite(h->n, sizeof(long), h->nb, f) == (size_t) h->nb;
+    return(ok ? 0 : -1);
+} // desa_hdr
+
+// Reads a delay histogram written by desa_hdr into an initialised h
+static int carrega_hdr(FILE *f, shdr *h){
+    int ok, nb;
+
+    ok = fread(&nb, sizeof(nb), 1, f) == 1 && nb >= 0;
+    ok = ok && fread(&h->samples, sizeof(h->samples), 1, f) == 1;
+    ok = ok && fread(&h->sum, sizeof(h->sum), 1, f) == 1;
+    ok = ok && fread(&h->min, sizeof(h->min), 1, f) == 1;
+    ok = ok && fread(&h->max, sizeof(h->max), 1, f) == 1;
+    if(ok && nb > 0){
+        grow_hdr(h, nb - 1);
+        ok = fread(h->n, sizeof(long), nb, f) == (size_t) nb;
+    }
+    return(ok ? 0 : -1);
+} // carrega_hdr
+
+// Writes the statistics gathered so far to f (checkpoint)
+int desa_stats(FILE *f, sstats *sts, int ntc){
+    int c, ok;
+
+    ok = fwrite(sts->nca, sizeof(long), ntc, f) == (size_t) ntc;
+    ok = ok && fwrite(sts->gload, sizeof(long), ntc, f) == (size_t) ntc;
+    for(c = 0; ok && c < ntc; c++){
+        ok = fwrite(&sts->nqhist[c], sizeof(long), 1, f) == 1;
+        ok = ok && fwrite(sts->qhist[c], sizeof(double), sts->nqhist[c], f) == (size_t) sts->nqhist[c];
+        ok = ok && desa_hdr(f, &sts->dqhist[c]) == 0;
+        ok = ok && desa_hdr(f, &sts->dshist[c]) == 0;
+        ok = ok && desa_hdr(f, &sts->dthist[c]) == 0;
+    }
+    return(ok ? 0 : -1);
+} // desa_stats
+
+// Reads the statistics written by desa_stats into sts (from init_stats)
+int carrega_stats(FILE *f, sstats *sts, int ntc){
+    int c, ok;
+    long n;
+
+    ok = fread(sts->nca, sizeof(long), ntc, f) == (size_t) ntc;
+    ok = ok && fread(sts->gload, sizeof(long), ntc, f) == (size_t) ntc;
+    for(c = 0; ok && c < ntc; c++){
+        ok = fread(&n, sizeof(long), 1, f) == 1 && n > 0;
+        if(ok && n > sts->nqhist[c])
+            grow_qhist(sts, c, n - 1);
+        ok = ok && fread(sts->qhist[c], sizeof(double), n, f) == (size_t) n;
+        ok = ok && carrega_hdr(f, &sts->dqhist[c]) == 0;
+        ok = ok && carrega_hdr(f, &sts->dshist[c]) == 0;
+        ok = ok && carrega_hdr(f, &sts->dthist[c]) == 0;
+    }
+    return(ok ? 0 : -1);
+} // carrega_stats
+
+// Adds the statistics gathered in src (one replication) to dst
+void suma_stats(sstats *dst, sstats *src, int ntc){
+    int s, d;
+
+    for(s = 0; s < ntc; s++){
+        dst->nca[s]   += src->nca[s];
+        dst->gload[s] += src->gload[s];
+        if(src->nqhist[s] > dst->nqhist[s])
+            grow_qhist(dst, s, src->nqhist[s] - 1);
+        for(d = 0; d < src->nqhist[s]; d++)
+            dst->qhist[s][d] += src->qhist[s][d];
+        suma_hdr(&dst->dqhist[s], &src->dqhist[s]);
+        suma_hdr(&dst->dshist[s], &src->dshist[s]);
+        suma_hdr(&dst->dthist[s], &src->dthist[s]);
+    }
+} // suma_stats
+
+// Inverse of the standard normal cdf (Acklam's rational approximation,
+// relative error below 1.2e-9)
+double inv_normal(double p){
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02,
+        -2.759285104469687e+02, 1.383577518672690e+02, -3.066479806614716e+01,
+         2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02,
+        -1.556989798598866e+02, 6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01,
+        -2.400758277161838e+00, -2.549732539343734e+00, 4.374664141464968e+00,
+         2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01,
+         2.445134137142996e+00, 3.754408661907416e+00};
+    double q, r;
+
+    if(p <= 0.0 || p >= 1.0)
+        ERROR((ofile, "ERROR inv_normal: p %lf out of (0,1)\n", p));
+    if(p < 0.02425){
+        q = sqrt(-2 * log(p));
+        return((((((c[0]*q+c[1])*q+c[2])*q+c[3])*q+c[4])*q+c[5]) /
+                ((((d[0]*q+d[1])*q+d[2])*q+d[3])*q+1));
+    }
+    if(p > 1 - 0.02425){
+        q = sqrt(-2 * log(1 - p));
+        return(-(((((c[0]*q+c[1])*q+c[2])*q+c[3])*q+c[4])*q+c[5]) /
+                 ((((d[0]*q+d[1])*q+d[2])*q+d[3])*q+1));
+    }
+    q = p - 0.5;
+    r = q * q;
+    return((((((a[0]*r+a[1])*r+a[2])*r+a[3])*r+a[4])*r+a[5])*q /
+           (((((b[0]*r+b[1])*r+b[2])*r+b[3])*r+b[4])*r+1));
+} // inv_normal
+
+// Value t of the Student t distribution with df degrees of freedom for a
+// double-sided CI of significance alpha: P(T <= t) = 1 - alpha/2.
+// Exact for df 1 and 2, Cornish-Fisher expansion otherwise (error < 0.1%)
+double t_student(int df, double alpha){
+    double p = 1 - alpha / 2;
+    double z, z2, v = df;
+
+    if(df < 1)
+        ERROR((ofile, "ERROR t_student: %d degrees of freedom\n", df));
+    if(df == 1)
+        return(tan(M_PI * (p - 0.5)));
+    if(df == 2)
+        return((2 * p - 1) / sqrt(2 * p * (1 - p)));
+    z  = inv_normal(p);
+    z2 = z * z;
+    return(z + z * (z2 + 1) / (4 * v)
+             + z * ((5 * z2 + 16) * z2 + 3) / (96 * v * v)
+             + z * (((3 * z2 + 19) * z2 + 17) * z2 - 15) / (384 * v * v * v)
+             + z * ((((79 * z2 + 776) * z2 + 1482) * z2 - 1920) * z2 - 945) / (92160 * v * v * v * v));
+} // t_student
+
+// Computes the mean of the n observations y (one per replication) and
+// returns the half width of its Student t confidence interval
+double compute_confidence_interval_t(double *y, int n, double alpha, double *mean){
+    int i;
+    double m = 0.0, s = 0.0;
+
+    for(i = 0; i < n; i++)
+        m += y[i];
+    m = m / n;
+    *mean = m;
+    if(n < 2)
+        return(0.0);
+    for(i = 0; i < n; i++)
+        s += (y[i] - m) * (y[i] - m);
+    s = sqrt(s / (n - 1));
+    return(t_student(n - 1, alpha) * s / sqrt(n));
+} // compute_confidence_interval_t
+
+// Control variate estimator of the mean of the n (>= 3) observations y with
+// the paired control x of known mean mux: ybar - beta (xbar - mux), beta
+// the least squares slope. Returns the half width of its Student t CI
+// (n - 2 degrees of freedom) and leaves the estimate in mean, beta and the
+// variance reduction Var(ybar) / Var(estimate) in reduction.
+double compute_control_variate_ci(double *y, double *x, int n, double mux, double alpha,
+                                  double *mean, double *beta, double *reduction){
+    int i;
+    double my = 0.0, mx = 0.0, sxx = 0.0, sxy = 0.0, syy = 0.0, b, v;
+
+    if(n < 3)
+        ERROR((ofile, "ERROR compute_control_variate_ci: %d observations\n", n));
+    for(i = 0; i < n; i++){
+        my += y[i];
+        mx += x[i];
+    }
+    my /= n;
+    mx /= n;
+    for(i = 0; i < n; i++){
+        sxx += (x[i] - mx) * (x[i] - mx);
+        sxy += (x[i] - mx) * (y[i] - my);
+        syy += (y[i] - my) * (y[i] - my);
+    }
+    b = (sxx > 0) ? sxy / sxx : 0.0;
+    *beta = b;
+    *mean = my - b * (mx - mux);
+    v = (syy - b * sxy) / (n - 2) * (1.0 / n + ((sxx > 0) ? (mx - mux) * (mx - mux) / sxx : 0.0));
+    if(v < 0) v = 0;
+    *reduction = (v > 0) ? syy / (n - 1) / n / v : 1.0;
+    return(t_student(n - 2, alpha) * sqrt(v));
+} // compute_control_variate_ci
+
 // Collect and print the statistics
 void collect_stats(sstats sts, int ntc){
     int s, c;
@@ -242,6 +999,11 @@ void collect_stats(sstats sts, int ntc){
     MESSAGE((ofile, "----- Resum dels Resultats de la Simulació ----------------\n"));
     MESSAGE((ofile, "-----------------------------------------------------------\n"));
 
+    if(sts.mser != NULL){
+        fprintf(ofile,"Escalfament MSER-%d: truncat a t = %.2lf (%d de %d lots descartats)\n",
+                MSERBATCH, sts.mser->ttrunc, sts.mser->d, sts.mser->k);
+        fprintf(ofile,"\n");
+    }
     fprintf(ofile,"Nombre de clients atesos: ");
     fprintf(ofile,"(total %ld promig %6.1lf)", suma_vect(sts.nca,ntc), mean_vect(sts.nca, ntc));
     fprintf(ofile,"\n");
@@ -250,22 +1012,22 @@ void collect_stats(sstats sts, int ntc){
     // Temps promig
     fprintf(ofile,"Numbre promig de clients a cua/caixa             : ");
     for(s = 0; s < ntc; s++){     
-        fprintf(ofile,"%8.1lf", mean_hist(sts.qhist[s], MAXQUHIST));
+        fprintf(ofile,"%8.1lf", mean_thist(sts.qhist[s], sts.nqhist[s]));
     }
     fprintf(ofile,"\n");
     fprintf(ofile,"Temps promig de cua a cada caixa                 : ");
     for(s = 0; s < ntc; s++){     
-        fprintf(ofile,"%8.1lf", mean_hist(sts.dqhist[s], MAXDELHIST));
+        fprintf(ofile,"%8.1lf", mean_hdr(&sts.dqhist[s]));
     }
     fprintf(ofile,"\n");
     fprintf(ofile,"Temps promig de servei a cada caixa              : ");
     for(s = 0; s < ntc; s++){     
-        fprintf(ofile,"%8.1lf", mean_hist(sts.dshist[s], MAXDELHIST));
+        fprintf(ofile,"%8.1lf", mean_hdr(&sts.dshist[s]));
     }
     fprintf(ofile,"\n");
     fprintf(ofile,"Temps promig al super dels clients de cada caixa : ");
     for(s = 0; s < ntc; s++){     
-        fprintf(ofile,"%8.1lf", mean_hist(sts.dthist[s], MAXDELHIST));
+        fprintf(ofile,"%8.1lf", mean_hdr(&sts.dthist[s]));
     }
     fprintf(ofile,"\n");
     fprintf(ofile,"\n");
@@ -273,22 +1035,22 @@ void collect_stats(sstats sts, int ntc){
     // Temps min
     fprintf(ofile,"Nombre minim de clients a cua/caixa              : ");
     for(s = 0; s < ntc; s++){     
-        fprintf(ofile,"%8ld", min_hist(sts.qhist[s], MAXQUHIST));
+        fprintf(ofile,"%8ld", min_thist(sts.qhist[s], sts.nqhist[s]));
     }
     fprintf(ofile,"\n");
     fprintf(ofile,"Temps minim de cua a cada caixa                  : ");
     for(s = 0; s < ntc; s++){     
-        fprintf(ofile,"%8ld", min_hist(sts.dqhist[s], MAXDELHIST));
+        fprintf(ofile,"%8.1lf", sts.dqhist[s].min);
     }
     fprintf(ofile,"\n");
     fprintf(ofile,"Temps minim de servei a cada caixa               : ");
     for(s = 0; s < ntc; s++){     
-        fprintf(ofile,"%8ld", min_hist(sts.dshist[s], MAXDELHIST));
+        fprintf(ofile,"%8.1lf", sts.dshist[s].min);
     }
     fprintf(ofile,"\n");
     fprintf(ofile,"Temps minim al super dels clients de cada caixa  : ");
     for(s = 0; s < ntc; s++){     
-        fprintf(ofile,"%8ld", min_hist(sts.dthist[s], MAXDELHIST));
+        fprintf(ofile,"%8.1lf", sts.dthist[s].min);
     }
     fprintf(ofile,"\n");
     fprintf(ofile,"\n");
@@ -296,23 +1058,36 @@ void collect_stats(sstats sts, int ntc){
     // Temps max
     fprintf(ofile,"Nombre maxim de clients a la cua/caixa           : ");
     for(s = 0; s < ntc; s++){     
-        fprintf(ofile,"%8ld", max_hist(sts.qhist[s], MAXQUHIST));
+        fprintf(ofile,"%8ld", max_thist(sts.qhist[s], sts.nqhist[s]));
     }
     fprintf(ofile,"\n");
     fprintf(ofile,"Temps maxim de cua a cada caixa                  : ");
     for(s = 0; s < ntc; s++){     
-        fprintf(ofile,"%8ld", max_hist(sts.dqhist[s], MAXDELHIST));
+        fprintf(ofile,"%8.1lf", sts.dqhist[s].max);
     }
     fprintf(ofile,"\n");
     fprintf(ofile,"Temps maxim de servei a cada caixa               : ");
     for(s = 0; s < ntc; s++){     
-        fprintf(ofile,"%8ld", max_hist(sts.dshist[s], MAXDELHIST));
+        fprintf(ofile,"%8.1lf", sts.dshist[s].max);
     }
     fprintf(ofile,"\n");
     
     fprintf(ofile,"Temps maxim al super dels clients segons caixa   : ");
     for(s = 0; s < ntc; s++){     
-        fprintf(ofile,"%8ld", max_hist(sts.dthist[s], MAXDELHIST));
+        fprintf(ofile,"%8.1lf", sts.dthist[s].max);
+    }
+    fprintf(ofile,"\n");
+    fprintf(ofile,"\n");
+
+    // Percentils (histogrames log-lineals)
+    fprintf(ofile,"Percentil 95 del temps de cua a cada caixa       : ");
+    for(s = 0; s < ntc; s++){     
+        fprintf(ofile,"%8.1lf", percentile_hdr(&sts.dqhist[s], 95));
+    }
+    fprintf(ofile,"\n");
+    fprintf(ofile,"Percentil 95 del temps al super segons caixa     : ");
+    for(s = 0; s < ntc; s++){     
+        fprintf(ofile,"%8.1lf", percentile_hdr(&sts.dthist[s], 95));
     }
     fprintf(ofile,"\n");
     fprintf(ofile,"\n");
@@ -323,22 +1098,22 @@ void collect_stats(sstats sts, int ntc){
         
     for(s = 0; s < ntc; s++){
         fprintf(ofile, "CUA %d nombre clients en espera a cua ", s);
-        print_hist(ofile, sts.qhist[s], MAXQUHIST,"", MAXPRINTCOL);    
+        print_thist(ofile, sts.qhist[s], sts.nqhist[s],"", MAXPRINTCOL);    
     }
     
     for(s = 0; s < ntc; s++){
         fprintf(ofile, "CUA %d temps d'espera a cua ", s);
-        print_hist(ofile, sts.dqhist[s], MAXDELHIST,"", MAXPRINTCOL);    
+        print_hdr(ofile, &sts.dqhist[s], "", MAXPRINTCOL);    
     }
 
     for(s = 0; s < ntc; s++){
         fprintf(ofile, "CUA %d temps d'espera de servei a caixa ", s);
-        print_hist(ofile, sts.dshist[s], MAXDELHIST,"", MAXPRINTCOL);    
+        print_hdr(ofile, &sts.dshist[s], "", MAXPRINTCOL);    
     }
     
     for(s = 0; s < ntc; s++){
         fprintf(ofile, "CUA %d temps total al super segons caixa ", s);
-        print_hist(ofile, sts.dthist[s], MAXDELHIST,"", MAXPRINTCOL);    
+        print_hdr(ofile, &sts.dthist[s], "", MAXPRINTCOL);    
     }
     
     time_header("END");
@@ -368,40 +1143,61 @@ void inc_stats(long **v, int row, int col, int maxrow, int maxcol){
         (*v)[row]++;
 } // inc_stats
 
-// Actualitza les estadístiques del tamany de cua des de l'event/temps anterior 
-// tant a l'event/temps actual ta
-void actualitzar_stats_cua(scua *cues, int ntc, float tant, float ta, sstats *sts, int maxqu){
-    int t, c;
+// Afegeix a l'histograma de la cua c el temps que ha estat amb la longitud
+// actual des del seu darrer canvi (cua->tcanvi) fins a ta, i marca ta com a
+// nou canvi. Cost O(1): s'ha de cridar just abans de canviar la longitud.
+// L'histograma creix si la cua supera la longitud mes gran vista.
+void actualitzar_stats_caixer(scua *cua, int c, float ta, sstats *sts){
     int posh;
-    
-    for(c = 0; c < ntc; c++){
-        posh = cues[c].lon_cua;
-        if(posh >= maxqu){
-            printf("%lf ERROR: actualitzar stats incrementant pos %d i es fora de rang %d", 
-                    ta, posh, maxqu);
-            exit(0);
-        }
-        sts->qhist[c][posh] += (floor(ta) - floor(tant));
+
+    posh = cua->lon_cua;
+    if(sts->mser != NULL && sts->mser->actiu)
+        guarda_obs(sts->mser, 'L', c, posh, cua->tcanvi, ta, 0);
+    else{
+        if(posh >= sts->nqhist[c])
+            grow_qhist(sts, c, posh);
+        sts->qhist[c][posh] += (double) ta - (double) cua->tcanvi;
     }
+    cua->tcanvi = ta;
+} // actualitzar_stats_caixer
+
+// Tanca les estadístiques de totes les cues al temps final ta
+void actualitzar_stats_cua(scua *cues, int ntc, float ta, sstats *sts){
+    int c;
+    
+    for(c = 0; c < ntc; c++)
+        actualitzar_stats_caixer(&cues[c], c, ta, sts);
     
 } // actualitzar_stats_cua
 
+// llavor 0: es continua un punt de control amb l'estat del generador desat
 void print_configuracio(long int llavor, int ntc){
     fprintf(ofile, "----------------------------------------------------------\n");
     fprintf(ofile, "---------- Configuracio Programa -------------------------\n");
     fprintf(ofile, "----------------------------------------------------------\n");
 
-    fprintf(ofile,"Random seed, seed chosen   : %ld\n",llavor);
+    if(llavor != 0)
+        fprintf(ofile,"Random seed, seed chosen   : %ld\n",llavor);
+    else
+        fprintf(ofile,"Random seed, seed chosen   : continua del punt de control\n");
     fprintf(ofile,"\n");   
     fprintf(ofile,"Temps obertura supermercat : %.1lf\n", OBRIRTIME);
     fprintf(ofile,"Temps tancar supermercat   : %.1lf\n", TANCARTIME);
     fprintf(ofile,"\n");
-    fprintf(ofile,"Temps mig entre arribades  : %d\n", ARRIVAL);
+    fprintf(ofile,"Temps mig entre arribades  : %g\n", temps_arribada);
     fprintf(ofile,"Temps mig de servei        : %d\n", SERVICE);
     fprintf(ofile,"\n");
-    fprintf(ofile,"Nombre total de caixers    : %d\n", ntc);    
+    fprintf(ofile,"Nombre total de caixers    : %d\n", ntc);
+    fprintf(ofile,"Caixers rapids             : %d\n", n_rapids);    
+    fprintf(ofile,"Fraccio de clients rapids  : %g\n", fraccio_rapids);
+    fprintf(ofile,"Escalfament (MSER-%d)       : %s\n", MSERBATCH, escalfament ? "truncacio automatica" : "no");
+    if(politica == ENC_JSQD)
+        fprintf(ofile,"Encaminament               : %s (d = %d)\n", nom_politica(politica), enc_d);
+    else
+        fprintf(ofile,"Encaminament               : %s\n", nom_politica(politica));
     fprintf(ofile,"-----------------------------------------------------------\n");
     fprintf(ofile,"\n");
-    fprintf(ofile,"--- Traces de Seguiment del programa (0 = NO, 1 = SI) : %d \n", anyDEBUG);
+    fprintf(ofile,"--- Traces de Seguiment del programa (SEV_TRACA, mascara) : 0x%02x -> %s\n", 
+            traca_cats, TRACAFILENAME);
     fprintf(ofile,"\n");
 } // print_configuracio
\ No newline at end of file
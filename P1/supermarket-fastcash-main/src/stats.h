@@ -24,17 +24,41 @@
 #define STSWARMUP       0  // WARMP-up period statistics: needed for error checks
 #define STSSTEADY       1  // STEADY state statistics
 #define STSSTATES       2  // Statistics divided in ramp-up 0 and steady state 1
+#define STSALPHA     0.05  // Significance level (alpha) of the confidence intervals
+#define MSERBATCH       5  // Observations per batch of the MSER warm-up detector (MSER-5)
+#define MSERKMIN       16  // Batches before the online MSER rule may end the warm-up
+#define MSERKMAX    16384  // Batches at which the warm-up is decided anyway (power of two; bounds the held back log)
+
+// Log-linear (HDR style) histogram of non-negative values. Values below
+// 2^bits resolution units have one bucket each; above, every power of two is
+// split in 2^(bits-1) buckets, so the relative error is below 2^-bits.
+// The bucket vector grows on demand and sum/min/max are kept exact.
+typedef struct{
+    long   *n;       // counts per bucket [nb]
+    int     nb;      // buckets allocated
+    int     bits;    // precision: 2^(bits-1) buckets per power of two
+    long    samples; // values recorded
+    double  sum;     // exact sum of the values
+    double  min;     // exact minimum
+    double  max;     // exact maximum
+}shdr;
+
+typedef struct smser smser; // MSER-5 warm-up detector (stats.c)
+typedef struct sombra sombra; // Shadow M/M/c queues for the control variate (stats.c)
 
 // Estructure grouping all measures and metrics related to statistics and 
 // simulation output results
 typedef struct{
     // statistics gathered along the simulation
-    long  **qhist;  // queue length histogram [ntc][MAXQUHIST]
-    long  **dqhist; // Delay histogram in queue in ?? units [ntc][MAXDELHIST]
-    long  **dshist;  // Delay service histogram in ?? units [ntc][MAXDELHIST]
-    long  **dthist;  // Delay total histogram in ?? units [ntc][MAXDELHIST]
+    double **qhist; // time spent with each queue length [ntc][nqhist[ntc]]
+    long   *nqhist; // Allocated length of each qhist row (grows on demand) [ntc]
+    shdr   *dqhist; // Delay histogram in queue [ntc]
+    shdr   *dshist; // Delay service histogram [ntc]
+    shdr   *dthist; // Delay total histogram [ntc]
     long   *nca;    // Number of served clients by each cashier [ntc]
     long   *gload;  // Clients generated at each cashier in slots [ntc]
+    smser  *mser;   // Warm-up detector (NULL if the whole run is reported)
+    sombra *ombra;  // Shadow M/M/c queues (NULL if there is no control variate)
     
     // statistics derived 
     double   utilization;      // Utilization
@@ -52,11 +76,43 @@ void collect_stats(sstats sts, int ntc);
 //void collect_stats();
 void free_stats(sstats sts, int ntc);
 long samples(long *h, long dimh);
+double mean_hist(long *h, long dimh);
+double mean_thist(double *h, long dimh);
+long min_thist(double *h, long dimh);
+long max_thist(double *h, long dimh);
+void print_thist(FILE *ofile, double *v, long length, char *msg, int num_col);
+long suma_vect(long *v, long dimh);
 int myround(double d);
 void print_hist(FILE *ofile, long *v, long length, char *msg, int num_col);
 void time_header(char *when);
 void inc_stats(long **v, int row, int col, int maxrow, int maxcol);
-void actualitzar_stats_cua(scua *cues, int ntc, float tant, float ta, sstats *sts, int maxqu);
+void inc_atesos(sstats *sts, int c, float ta);
+void inc_servei(sstats *sts, int c, float ta, float tq, float ts, int de_cua);
+void ini_mser(sstats *sts);
+void tanca_mser(sstats *sts);
+void ini_ombra(sstats *sts, int c);
+void inc_ombra(sstats *sts, int ini, int fin, float ta, float ts);
+double espera_ombra(sstats *sts);
+double espera_mmc(double lambda, double mu, int c, double T);
+void actualitzar_stats_caixer(scua *cua, int c, float ta, sstats *sts);
+void actualitzar_stats_cua(scua *cues, int ntc, float ta, sstats *sts);
 void print_configuracio(long int llavor, int ntc);
+long *sum_stn_hists(long *sum, long **h, long dimh, int numstns);
+void init_hdr(shdr *h, int bits);
+void free_hdr(shdr *h);
+void inc_hdr(shdr *h, double x);
+void suma_hdr(shdr *dst, shdr *src);
+double mean_hdr(shdr *h);
+double percentile_hdr(shdr *h, double p);
+void print_hdr(FILE *ofile, shdr *h, char *msg, int num_col);
+double mean_stn_hdr(shdr *h, int numstns);
+void suma_stats(sstats *dst, sstats *src, int ntc);
+int desa_stats(FILE *f, sstats *sts, int ntc);
+int carrega_stats(FILE *f, sstats *sts, int ntc);
+double inv_normal(double p);
+double t_student(int df, double alpha);
+double compute_confidence_interval_t(double *y, int n, double alpha, double *mean);
+double compute_control_variate_ci(double *y, double *x, int n, double mux, double alpha,
+                                  double *mean, double *beta, double *reduction);
 #endif	/* STATS_H */
 
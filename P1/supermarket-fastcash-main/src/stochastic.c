@@ -1,36 +1,154 @@
 /*
  * Programa exemple del funcionament d'una simulacio orientada en events
  * basada en el codi donat en el llibre Jorba, Capitol 2
- * 
+ *
  * LLibreria de funcions estocastiques del sistema de cues
- * 
+ *
+ * El generador es basat en comptadors (Philox4x32-10): el valor n d'un flux
+ * es una funcio pura de la clau (llavor i replicacio), del flux i de n.
+ * Cada proposit estocastic te el seu flux (arribades, classe del client i
+ * servei de cada caixer), de manera que afegir un caixer no desplaça els
+ * valors de la resta i les configuracions es poden comparar amb nombres
+ * aleatoris comuns. L'estat (clau i comptadors) es privat de cada fil.
+ *
  * File:   stochastic.c
  * Author: Dolors Sala
  */
 
 #include <math.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include "sev.h"
- 
-// A normalized random function giving values in the range [0..1]
+
+#define PHILOX_M0     0xD2511F53u   // multiplicadors de les rondes
+#define PHILOX_M1     0xCD9E8D57u
+#define PHILOX_W0     0x9E3779B9u   // increments de la clau entre rondes
+#define PHILOX_W1     0xBB67AE85u
+#define PHILOX_RONDES 10
+
+static _Thread_local uint32_t alea_clau[2];          // clau del fil (llavor i replicacio)
+static _Thread_local unsigned long long *alea_n;     // valors consumits de cada flux
+static _Thread_local int alea_nfluxos;               // fluxos amb comptador
+
+// Barreja de 64 bits del splitmix64
+static unsigned long long barreja(unsigned long long z){
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return(z ^ (z >> 31));
+} // barreja
+
+// Xifra el comptador ctr amb la clau k (Philox4x32, 10 rondes)
+static void philox(uint32_t ctr[4], const uint32_t clau[2]){
+    uint32_t k0 = clau[0], k1 = clau[1];
+    uint64_t p0, p1;
+    int r;
+
+    for(r = 0; r < PHILOX_RONDES; r++){
+        p0 = (uint64_t) PHILOX_M0 * ctr[0];
+        p1 = (uint64_t) PHILOX_M1 * ctr[2];
+        ctr[0] = (uint32_t)(p1 >> 32) ^ ctr[1] ^ k0;
+        ctr[1] = (uint32_t) p1;
+        ctr[2] = (uint32_t)(p0 >> 32) ^ ctr[3] ^ k1;
+        ctr[3] = (uint32_t) p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+} // philox
+
+// Inicialitza el generador del fil amb la llavor i el flux (replicacio) donats.
+// Replicacions diferents de la mateixa llavor donen sequencies independents.
+void ini_alea(unsigned long long llavor, int flux){
+    unsigned long long k;
+
+    k = barreja(llavor + 0x9e3779b97f4a7c15ULL * (unsigned long long)(flux + 1));
+    alea_clau[0] = (uint32_t) k;
+    alea_clau[1] = (uint32_t)(k >> 32);
+    if(alea_n != NULL)
+        memset(alea_n, 0, alea_nfluxos * sizeof(unsigned long long));
+} // ini_alea
+
+// Allibera els comptadors dels fluxos del fil
+void allibera_alea(void){
+    free(alea_n);
+    alea_n = NULL;
+    alea_nfluxos = 0;
+} // allibera_alea
+
+// Desa l'estat del generador del fil (clau i comptadors dels fluxos)
+int desa_alea(FILE *f){
+    int ok;
+
+    ok = fwrite(alea_clau, sizeof(alea_clau), 1, f) == 1;
+    ok = ok && fwrite(&alea_nfluxos, sizeof(alea_nfluxos), 1, f) == 1;
+    if(ok && alea_nfluxos > 0)
+        ok = fwrite(alea_n, sizeof(unsigned long long), alea_nfluxos, f) == (size_t) alea_nfluxos;
+    return(ok ? 0 : -1);
+} // desa_alea
+
+// Recupera l'estat del generador desat amb desa_alea
+int carrega_alea(FILE *f){
+    int n, ok;
+
+    ok = fread(alea_clau, sizeof(alea_clau), 1, f) == 1;
+    ok = ok && fread(&n, sizeof(n), 1, f) == 1 && n >= 0;
+    if(!ok)
+        return(-1);
+    allibera_alea();
+    if(n > 0){
+        alea_n = (unsigned long long *) malloc(n * sizeof(unsigned long long));
+        if(alea_n == NULL || fread(alea_n, sizeof(unsigned long long), n, f) != (size_t) n)
+            return(-1);
+        alea_nfluxos = n;
+    }
+    return(0);
+} // carrega_alea
+
+// Seguent valor uniforme (0..1) del flux donat. Cada bloc de Philox dona
+// 128 bits: el valor n del flux fa servir la meitat n%2 del bloc n/2.
+double alea(int flux){
+    unsigned long long n, u, *v;
+    uint32_t ctr[4];
+    int f;
+
+    if(flux >= alea_nfluxos){
+        f = (2 * alea_nfluxos > flux) ? 2 * alea_nfluxos : flux + 1;
+        v = (unsigned long long *) realloc(alea_n, f * sizeof(unsigned long long));
+        if(v == NULL){
+            fprintf(stderr, "ERROR alea: No hi ha prou memoria pels fluxos\n");
+            exit(EXIT_FAILURE);
+        }
+        memset(v + alea_nfluxos, 0, (f - alea_nfluxos) * sizeof(unsigned long long));
+        alea_n = v;
+        alea_nfluxos = f;
+    }
+    n = alea_n[flux]++;
+    ctr[0] = (uint32_t)(n >> 1);
+    ctr[1] = (uint32_t)(n >> 33);
+    ctr[2] = (uint32_t) flux;
+    ctr[3] = 0;
+    philox(ctr, alea_clau);
+    u = (n & 1) ? ((unsigned long long) ctr[3] << 32 | ctr[2])
+                : ((unsigned long long) ctr[1] << 32 | ctr[0]);
+    return(((u >> 11) + 0.5) * (1.0 / 9007199254740992.0));
+} // alea
+
+// Valor d'una exponencial de mitjana m del flux donat
+float expo_flux(int flux, float m){
+    return(-m*log(alea(flux)));
+} // expo_flux
+
+// Temps de servei d'un client al caixer donat (flux propi de cada caixer)
+float temps_servei(int caixer){
+    return(1 + expo_flux(ALEA_SERVEI + caixer, SERVICE));
+} // temps_servei
+
+// A normalized random function giving values in the range (0..1)
 double drand(void){
-    double ret = 0.0;
-    double r = 0;
-    
-    r = rand();
-    ret = r / (double) RAND_MAX;
-    return(ret);
+    return(alea(ALEA_GENERAL));
 } // drand
 
 // Provides the next random value of an exponential distribution of mean m
 float expo(float m){
-    static double d = 0.0;
-
-    d = drand();
-#if (DEBUGalea == 1)
-    fprintf(ofile, "Número aleatori: %lf -- ", d);
-#endif
-    return(-m*log(d));
+    return(expo_flux(ALEA_GENERAL, m));
 }
-
-
@@ -0,0 +1,141 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Telemetria en viu en memoria compartida POSIX (-g segment, veure
+ * telemetria.h). El simulador es l'unic escriptor: obre el segment, hi
+ * publica l'estat cada telemetria_periode events i l'esborra en acabar (els
+ * lectors que el tenen obert en conserven la darrera publicacio).
+ *
+ * File:   telemetria.c
+ * Author: Dolors Sala
+ */
+
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+#include "sev.h"
+#include "stats.h"
+#include "telemetria.h"
+
+stelemetria *telemetria = NULL;
+long long telemetria_events = 0;
+long long telemetria_periode = TELEPERIODE;
+long long telemetria_seguent = TELEPERIODE;
+static char *nom_segment = NULL;
+static size_t mida_segment;
+
+// Crea el segment nom (amb / inicial o sense) per ntc caixers. Retorna 0
+// si va be.
+int obre_telemetria(const char *nom, int ntc){
+#ifndef _WIN32
+    int fd;
+    void *p;
+
+    nom_segment = (char *) malloc(strlen(nom) + 2);
+    if (nom_segment == NULL)
+        return (-1);
+    sprintf(nom_segment, "%s%s", (nom[0] == '/') ? "" : "/", nom);
+    mida_segment = MIDA_TELEMETRIA(ntc);
+    fd = shm_open(nom_segment, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, (off_t) mida_segment) != 0){
+        if (fd >= 0){
+            close(fd);
+            shm_unlink(nom_segment);
+        }
+        free(nom_segment);
+        nom_segment = NULL;
+        return (-1);
+    }
+    p = mmap(NULL, mida_segment, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED){
+        shm_unlink(nom_segment);
+        free(nom_segment);
+        nom_segment = NULL;
+        return (-1);
+    }
+    telemetria = (stelemetria *) p;
+    memcpy(telemetria->magic, TELEMAGIC, sizeof(telemetria->magic));
+    telemetria->versio = TELEVERSIO;
+    telemetria->ntc = ntc;
+    telemetria->n_rapids = n_rapids;
+    telemetria->pid = (int) getpid();
+    telemetria->tancar = TANCARTIME;
+    telemetria_events = 0;
+    telemetria_periode = (TELECAIXER * (long long) ntc > TELEPERIODE) ? TELECAIXER * (long long) ntc : TELEPERIODE;
+    telemetria_seguent = telemetria_periode;
+    return (0);
+#else
+    (void) nom;
+    (void) ntc;
+    return (-1);   // sense memoria compartida POSIX
+#endif
+} // obre_telemetria
+
+// Temps de cua mitja dels n clients que han començat el servei als
+// caixers ini..fin-1, amb 0 pels que no han fet cua (0 si no n'hi ha)
+static double espera_caixers(sstats *sts, int ini, int fin, long long *n){
+    double s = 0;
+    int c;
+
+    *n = 0;
+    for (c = ini; c < fin; c++){
+        s += sts->dqhist[c].sum;
+        *n += sts->dshist[c].samples;
+    }
+    return ((*n > 0) ? s / *n : 0.0);
+} // espera_caixers
+
+// Publica l'estat de la simulacio a l'instant ta (acabat = 1 l'ultim cop).
+// Cost O(ntc), un cop cada telemetria_periode events.
+void publica_telemetria(float ta, scua *cues, int ntc, sstats *sts, int acabat){
+    stelemetria *t = telemetria;
+    unsigned long long s;
+    long long nr, nl;
+    double er, el, servei = 0;
+    int c, ocupats = 0;
+
+    if (t == NULL)
+        return;
+    telemetria_seguent = telemetria_events + telemetria_periode;
+    // Es calcula tot abans d'obrir l'escriptura per fer-la tan curta com es pugui
+    er = espera_caixers(sts, 0, n_rapids, &nr);
+    el = espera_caixers(sts, n_rapids, ntc, &nl);
+    for (c = 0; c < ntc; c++)
+        servei += sts->dshist[c].sum;
+
+    s = atomic_load_explicit(&t->seq, memory_order_relaxed);
+    atomic_store_explicit(&t->seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (c = 0; c < ntc; c++){
+        t->lon_cua[c] = cues[c].lon_cua;
+        ocupats += cues[c].caixa;
+    }
+    t->ocupats = ocupats;
+    t->ta = ta;
+    t->events = telemetria_events;
+    t->atesos = nr + nl;
+    t->espera = (nr + nl > 0) ? (er * nr + el * nl) / (nr + nl) : 0.0;
+    t->espera_rapids = er;
+    t->espera_lents = el;
+    t->temps_super = (nr + nl > 0) ? t->espera + servei / (nr + nl) : 0.0;
+    t->acabat = acabat;
+    atomic_store_explicit(&t->seq, s + 2, memory_order_release);
+} // publica_telemetria
+
+// Tanca el segment i l'esborra (no fa res sense -g)
+void tanca_telemetria(void){
+#ifndef _WIN32
+    if (telemetria != NULL){
+        munmap(telemetria, mida_segment);
+        shm_unlink(nom_segment);
+    }
+    free(nom_segment);
+#endif
+    telemetria = NULL;
+    nom_segment = NULL;
+} // tanca_telemetria
@@ -0,0 +1,69 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Declaracions de la telemetria en viu (-g segment)
+ *
+ * Cada telemetria_periode events el motor sequencial (i el de processos)
+ * copia l'estat de la simulacio a un segment de memoria compartida POSIX amb
+ * el format fix stelemetria. L'escriptura va protegida per un seqlock: el
+ * comptador seq es senar mentre el simulador escriu i un lector (supermon)
+ * torna a llegir si seq ha canviat o era senar. El simulador no espera mai
+ * ningu i el lector nomes llegeix.
+ *
+ * File:   telemetria.h
+ * Author: Dolors Sala
+ */
+
+#ifndef TELEMETRIA_H
+#define	TELEMETRIA_H
+
+#include <stdatomic.h>
+
+#define TELEMAGIC     "SEVTELEM"
+#define TELEVERSIO    1
+#define TELEPERIODE   1024   // events minims entre dues publicacions
+#define TELECAIXER    16     // events per caixer entre publicacions, perque el
+                             // cost O(ntc) de publicar sigui O(1) per event
+
+// Segment de memoria compartida: capçalera fixa i una longitud de cua per
+// caixer. Tot el que va despres de seq el protegeix el seqlock.
+typedef struct {
+    char magic[8];            // TELEMAGIC
+    int  versio;              // TELEVERSIO
+    int  ntc;                 // caixers (elements de lon_cua)
+    int  n_rapids;            // caixers rapids (els primers)
+    int  pid;                 // proces del simulador
+    _Atomic unsigned long long seq;   // seqlock: senar mentre s'escriu
+    int  acabat;              // 1 quan la simulacio ha acabat
+    int  ocupats;             // caixers atenent un client
+    double ta;                // rellotge de la simulacio
+    double tancar;            // hora de tancar (TANCARTIME)
+    long long events;         // events tractats
+    long long atesos;         // clients que han començat el servei
+    double espera;            // temps de cua mitja d'aquests clients (els que no
+                              // han fet cua compten 0, com a optim.c): tots,
+    double espera_rapids;     // els de les caixes rapides
+    double espera_lents;      // i els de la resta
+    double temps_super;       // temps de cua mes temps de servei mitjos d'aquests clients
+    int  lon_cua[];           // clients a la cua de cada caixer [ntc]
+} stelemetria;
+
+// Bytes del segment per ntc caixers
+#define MIDA_TELEMETRIA(ntc)  (sizeof(stelemetria) + (size_t) (ntc) * sizeof(int))
+
+extern stelemetria *telemetria;       // segment (NULL sense -g)
+extern long long telemetria_events;   // events tractats des de l'inici
+extern long long telemetria_periode;  // events entre publicacions
+extern long long telemetria_seguent;  // events de la seguent publicacio
+
+// Compta un event i publica l'estat cada telemetria_periode events
+#define TELEMETRIA(ta, cues, ntc, sts) \
+    do { if (telemetria != NULL && ++telemetria_events >= telemetria_seguent) \
+             publica_telemetria((ta), (cues), (ntc), (sts), 0); } while (0)
+
+int obre_telemetria(const char *nom, int ntc);
+void publica_telemetria(float ta, scua *cues, int ntc, sstats *sts, int acabat);
+void tanca_telemetria(void);
+
+#endif	/* TELEMETRIA_H */
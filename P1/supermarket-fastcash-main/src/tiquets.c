@@ -0,0 +1,235 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Arribades llegides de tiquets de caixa (-t fitxer, veure tiquets.h).
+ *
+ * La primera vegada el CSV es llegeix linia a linia i cada tiquet
+ * s'escriu directament al fitxer binari (a traves d'un fitxer temporal que
+ * es reanomena al final, per no deixar mai una conversio a mitges). Despres
+ * el binari es projecta en memoria: el motor nomes te a l'agenda la
+ * seguent arribada i va llegint els tiquets en ordre, de manera que el
+ * sistema operatiu carrega les pagines a mesura que calen.
+ *
+ * File:   tiquets.c
+ * Author: Dolors Sala
+ */
+
+#include <string.h>
+#include <ctype.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+#include "sev.h"
+#include "tiquets.h"
+
+#define TIQLINIA     512        // longitud maxima d'una linia del CSV
+#define TIQBUFFER    (1 << 20)  // buffer dels fitxers (bytes)
+
+const stiquet *tiquets = NULL;
+long long n_tiquets = 0;
+static void *projeccio = NULL;   // fitxer binari projectat (capçalera inclosa)
+static size_t mida_projeccio;
+
+// Llegeix el camp numeric que comença a *s i passa el separador que el
+// segueix. Retorna 0 si no hi ha cap numero.
+static int llegeix_camp(char **s, double *v){
+    char *fi;
+
+    *v = strtod(*s, &fi);
+    if (fi == *s)
+        return (0);
+    while (*fi == ' ' || *fi == '\t')
+        fi++;
+    if (*fi == ',' || *fi == ';' || *fi == '\t')
+        fi++;
+    *s = fi;
+    return (1);
+} // llegeix_camp
+
+// Converteix el CSV al fitxer binari bin. Retorna 0 si va be.
+static int converteix_csv(const char *csv, const char *bin, const struct stat *st){
+    FILE *fc, *fb;
+    char linia[TIQLINIA], *tmp, *s;
+    ctiquets c;
+    stiquet q;
+    double temps, articles, servei, anterior = 0;
+    long long nlinia = 0;
+    int ok = 1;
+
+    tmp = (char *) malloc(strlen(bin) + 5);
+    if (tmp == NULL)
+        return (-1);
+    sprintf(tmp, "%s.tmp", bin);
+    fc = fopen(csv, "r");
+    fb = fopen(tmp, "wb");
+    if (fc == NULL || fb == NULL){
+        if (fc != NULL) fclose(fc);
+        if (fb != NULL) fclose(fb);
+        free(tmp);
+        return (-1);
+    }
+    setvbuf(fc, NULL, _IOFBF, TIQBUFFER);
+    setvbuf(fb, NULL, _IOFBF, TIQBUFFER);
+
+    memset(&c, 0, sizeof(c));
+    memcpy(c.magic, TIQMAGIC, sizeof(c.magic));
+    c.versio = TIQVERSIO;
+    c.mida = sizeof(stiquet);
+    c.mida_csv = (long long) st->st_size;
+    c.data_csv = (long long) st->st_mtime;
+    ok = fwrite(&c, sizeof(c), 1, fb) == 1;   // es reescriu al final amb n i t0
+
+    memset(&q, 0, sizeof(q));
+    while (ok && fgets(linia, sizeof(linia), fc) != NULL){
+        nlinia++;
+        if (strchr(linia, '\n') == NULL && !feof(fc)){
+            fprintf(stderr, "ERROR tiquets: linia %lld de %s massa llarga\n", nlinia, csv);
+            ok = 0;
+            break;
+        }
+        for (s = linia; isspace((unsigned char) *s); s++)
+            ;
+        if (*s == '\0' || *s == '#')
+            continue;
+        if (!llegeix_camp(&s, &temps)){
+            if (c.n == 0)   // capçalera
+                continue;
+            fprintf(stderr, "ERROR tiquets: linia %lld de %s sense temps\n", nlinia, csv);
+            ok = 0;
+            break;
+        }
+        if (!llegeix_camp(&s, &articles) || articles < 0){
+            fprintf(stderr, "ERROR tiquets: linia %lld de %s sense articles\n", nlinia, csv);
+            ok = 0;
+            break;
+        }
+        if (!llegeix_camp(&s, &servei))
+            servei = 0;
+        if (c.n == 0)
+            c.t0 = anterior = temps;
+        if (temps < anterior){
+            fprintf(stderr, "ERROR tiquets: linia %lld de %s fora d'ordre (%g < %g)\n",
+                    nlinia, csv, temps, anterior);
+            ok = 0;
+            break;
+        }
+        anterior = temps;
+        q.temps = (float) (temps - c.t0);
+        q.articles = (int) articles;
+        q.servei = (float) servei;
+        ok = fwrite(&q, sizeof(q), 1, fb) == 1;
+        c.n++;
+    }
+    fclose(fc);
+    ok = ok && fseek(fb, 0, SEEK_SET) == 0 && fwrite(&c, sizeof(c), 1, fb) == 1;
+    if (fclose(fb) != 0)
+        ok = 0;
+    // Windows no reanomena sobre un fitxer existent
+    if (ok && (remove(bin), rename(tmp, bin) != 0))
+        ok = 0;
+    if (!ok)
+        remove(tmp);
+    free(tmp);
+    return (ok ? 0 : -1);
+} // converteix_csv
+
+// Projecta (o llegeix) el fitxer binari bin. Retorna 0 si es valid pel
+// CSV amb les dades st, i -1 si no existeix o s'ha de refer.
+static int carrega_binari(const char *bin, const struct stat *st){
+    const ctiquets *c;
+    struct stat sb;
+
+    if (stat(bin, &sb) != 0 || (size_t) sb.st_size < sizeof(ctiquets))
+        return (-1);
+    mida_projeccio = (size_t) sb.st_size;
+#ifndef _WIN32
+    int fd = open(bin, O_RDONLY);
+    if (fd < 0)
+        return (-1);
+    projeccio = mmap(NULL, mida_projeccio, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (projeccio == MAP_FAILED){
+        projeccio = NULL;
+        return (-1);
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(projeccio, mida_projeccio, MADV_SEQUENTIAL);
+#endif
+#else
+    FILE *f = fopen(bin, "rb");
+    if (f == NULL)
+        return (-1);
+    projeccio = malloc(mida_projeccio);
+    if (projeccio == NULL || fread(projeccio, 1, mida_projeccio, f) != mida_projeccio){
+        fclose(f);
+        tanca_tiquets();
+        return (-1);
+    }
+    fclose(f);
+#endif
+    c = (const ctiquets *) projeccio;
+    if (memcmp(c->magic, TIQMAGIC, sizeof(c->magic)) != 0 || c->versio != TIQVERSIO
+            || c->mida != (int) sizeof(stiquet)
+            || c->mida_csv != (long long) st->st_size || c->data_csv != (long long) st->st_mtime
+            || mida_projeccio != sizeof(ctiquets) + (size_t) c->n * sizeof(stiquet)){
+        tanca_tiquets();
+        return (-1);
+    }
+    tiquets = (const stiquet *) (c + 1);
+    n_tiquets = c->n;
+    return (0);
+} // carrega_binari
+
+// Prepara les arribades del CSV csv: fa servir el binari si es al dia i
+// si no el torna a fer. Retorna 0 si va be.
+int obre_tiquets(const char *csv){
+    struct stat st;
+    char *bin;
+    int ret;
+
+    if (stat(csv, &st) != 0)
+        return (-1);
+    bin = (char *) malloc(strlen(csv) + 5);
+    if (bin == NULL)
+        return (-1);
+    sprintf(bin, "%s.bin", csv);
+    ret = carrega_binari(bin, &st);
+    if (ret != 0 && converteix_csv(csv, bin, &st) == 0)
+        ret = carrega_binari(bin, &st);
+    free(bin);
+    if (ret == 0 && n_tiquets == 0){
+        fprintf(stderr, "ERROR tiquets: %s no te cap tiquet\n", csv);
+        tanca_tiquets();
+        ret = -1;
+    }
+    return (ret);
+} // obre_tiquets
+
+// Allibera la projeccio dels tiquets (no fa res si no n'hi ha)
+void tanca_tiquets(void){
+    if (projeccio != NULL){
+#ifndef _WIN32
+        munmap(projeccio, mida_projeccio);
+#else
+        free(projeccio);
+#endif
+    }
+    projeccio = NULL;
+    tiquets = NULL;
+    n_tiquets = 0;
+} // tanca_tiquets
+
+// Classe del client del tiquet i: 1 rapid (pocs articles), 0 lent
+int classe_tiquet(long long i){
+    return (tiquets[i].articles <= ARTICLES_RAPID);
+} // classe_tiquet
+
+// Temps de servei del client del tiquet i al caixer: l'observat si n'hi ha
+// i si no el del flux del caixer
+float servei_tiquet(long long i, int caixer){
+    return (tiquets[i].servei > 0 ? tiquets[i].servei : temps_servei(caixer));
+} // servei_tiquet
@@ -0,0 +1,59 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Declaracions de les arribades llegides de tiquets de caixa (-t fitxer)
+ *
+ * El fitxer de text (CSV) te una linia per tiquet, ordenades per temps:
+ *
+ *   temps,articles[,servei]
+ *
+ * temps en unitats del model (qualsevol origen: es resta el primer),
+ * articles del tiquet i temps de servei observat (si falta o es <= 0 es
+ * genera com sempre). Les linies buides, les que comencen per # i la
+ * capçalera es salten; el separador pot ser , ; o tabulador.
+ *
+ * El CSV es converteix un sol cop a un fitxer binari (nom.csv.bin) amb
+ * una capçalera (ctiquets) i els tiquets (stiquet) seguits, que es torna
+ * a fer si el CSV canvia de mida o de data. Les execucions seguents el
+ * projecten en memoria (mmap) sense llegir text.
+ *
+ * File:   tiquets.h
+ * Author: Dolors Sala
+ */
+
+#ifndef TIQUETS_H
+#define	TIQUETS_H
+
+#define TIQMAGIC      "SEVTIQUE"
+#define TIQVERSIO     1
+#define ARTICLES_RAPID 10    // tiquets amb prou pocs articles per anar a caixa rapida
+
+// Capçalera del fitxer binari (48 bytes)
+typedef struct {
+    char magic[8];       // TIQMAGIC
+    int  versio;         // TIQVERSIO
+    int  mida;           // sizeof(stiquet)
+    long long n;         // tiquets al fitxer
+    long long mida_csv;  // mida i data del CSV d'on surt (per saber si ha canviat)
+    long long data_csv;
+    double t0;           // temps del primer tiquet (origen restat)
+}ctiquets;
+
+// Un tiquet (16 bytes)
+typedef struct {
+    float temps;         // arribada des de l'obertura
+    float servei;        // temps de servei observat (<= 0 si no n'hi ha)
+    int   articles;      // articles del tiquet
+    int   res;           // reservat (alineacio)
+}stiquet;
+
+extern const stiquet *tiquets;   // tiquets en ordre (NULL: arribades aleatories)
+extern long long n_tiquets;
+
+int obre_tiquets(const char *csv);
+void tanca_tiquets(void);
+int classe_tiquet(long long i);
+float servei_tiquet(long long i, int caixer);
+
+#endif	/* TIQUETS_H */
@@ -0,0 +1,101 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Enregistrador de traces (flight recorder) en un buffer circular binari
+ *
+ * File:   traca.c
+ * Author: Dolors Sala
+ */
+
+#include <string.h>
+#include "sev.h"
+
+unsigned int traca_cats = 0;         // categories actives (0 = cap), comunes a tots els fils
+// Cada fil te el seu buffer, que es crea el primer cop que hi registra
+static _Thread_local rtraca *traca = NULL;        // buffer circular de TRACAMAX registres
+static _Thread_local unsigned long long n_traca;  // registres escrits des de l'inici
+
+// Converteix una llista de categories separades per comes en la mascara:
+// "serv,agenda,cua,quinaCua,alea", "tot" o "cap". NULL vol dir "tot".
+unsigned int parse_cats_traca(const char *cats){
+    unsigned int m = 0;
+    char buf[128], *c;
+
+    if (cats == NULL)
+        return (TRACAtot);
+    strncpy(buf, cats, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    for (c = strtok(buf, ","); c != NULL; c = strtok(NULL, ",")){
+        if (!strcmp(c, "tot") || !strcmp(c, "all"))    m |= TRACAtot;
+        else if (!strcmp(c, "serv"))                    m |= TRACAserv;
+        else if (!strcmp(c, "agenda"))                  m |= TRACAagenda;
+        else if (!strcmp(c, "cua"))                     m |= TRACAcua;
+        else if (!strcmp(c, "quinaCua"))                m |= TRACAquinaCua;
+        else if (!strcmp(c, "alea"))                    m |= TRACAalea;
+        else if (strcmp(c, "cap") && strcmp(c, "none"))
+            fprintf(stderr, "WARNING traca: categoria desconeguda %s\n", c);
+    }
+    return (m);
+} // parse_cats_traca
+
+// Activa les categories indicades (s'ha de cridar abans de crear fils)
+void ini_traca(const char *cats){
+    traca_cats = parse_cats_traca(cats);
+} // ini_traca
+
+// Guarda un registre al buffer circular del fil, sobreescrivint el mes antic
+void registra_traca(int cat, double t, int op, int que, int on, int lon, float valor){
+    rtraca *r;
+
+    if (traca == NULL){
+        traca = (rtraca *) calloc(TRACAMAX, sizeof(rtraca));
+        n_traca = 0;
+        if (traca == NULL)
+            return;
+    }
+    r = &traca[n_traca & (TRACAMAX - 1)];
+
+    r->t     = t;
+    r->valor = valor;
+    r->on    = on;
+    r->lon   = lon;
+    r->cat   = (char) cat;
+    r->op    = (char) op;
+    r->que   = (char) que;
+    n_traca++;
+} // registra_traca
+
+// Escriu el contingut del buffer del fil al fitxer filename (del mes antic al mes nou)
+// Retorna el nombre de registres escrits o NA si hi ha hagut un problema
+int bolca_traca(const char *filename){
+    FILE *f;
+    ctraca c;
+    unsigned long long i, ini;
+
+    if (traca == NULL)
+        return (NA);
+    f = fopen(filename, "wb");
+    if (f == NULL){
+        fprintf(stderr, "WARNING traca: no es pot obrir %s\n", filename);
+        return (NA);
+    }
+    memset(&c, 0, sizeof(c));
+    memcpy(c.magic, TRACAMAGIC, sizeof(c.magic));
+    c.versio  = TRACAVERSIO;
+    c.mida    = sizeof(rtraca);
+    c.n       = (n_traca < TRACAMAX) ? n_traca : TRACAMAX;
+    c.perduts = n_traca - c.n;
+    fwrite(&c, sizeof(c), 1, f);
+    ini = n_traca - c.n;
+    for (i = ini; i < n_traca; i++)
+        fwrite(&traca[i & (TRACAMAX - 1)], sizeof(rtraca), 1, f);
+    fclose(f);
+    return ((int) c.n);
+} // bolca_traca
+
+// Allibera el buffer del fil (cada fil ha de cridar-la en acabar)
+void allibera_traca(void){
+    free(traca);
+    traca = NULL;
+} // allibera_traca
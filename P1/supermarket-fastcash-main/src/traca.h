@@ -0,0 +1,64 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Declaracions de l'enregistrador de traces (flight recorder)
+ *
+ * Les traces es guarden en binari en un buffer circular de mida fixa en
+ * memoria i nomes s'escriuen a fitxer (bolca_traca) si hi ha un ERROR o si
+ * es demana. El fitxer es llegeix amb l'eina tools/decodetraca.
+ *
+ * File:   traca.h
+ * Author: Dolors Sala
+ */
+
+#ifndef TRACA_H
+#define	TRACA_H
+
+#define TRACAMAX      65536   // Registres del buffer circular (potencia de 2)
+#define TRACAMAGIC    "SEVTRACA"
+#define TRACAVERSIO   1
+
+// Categories de traces, seleccionables en execucio (variable d'entorn SEV_TRACA)
+#define TRACAserv     0x01    // seguiment del servei
+#define TRACAagenda   0x02    // seguiment de l'agenda
+#define TRACAcua      0x04    // seguiment de les cues
+#define TRACAquinaCua 0x08    // decisio de la cua on posar clients
+#define TRACAalea     0x10    // numeros aleatoris utilitzats
+#define TRACAtot      0x1f
+
+// Registre binari d'una traça (32 bytes)
+typedef struct {
+    double t;       // temps de simulacio
+    float  valor;   // valor associat: quan, temps de servei, espera...
+    int    on;      // caixer/cua (NA si no aplica)
+    int    lon;     // longitud de la cua o de l'agenda
+    char   cat;     // categoria TRACAxxx
+    char   op;      // operacio: 'P'osa, 'T'reu, 'C'ancela, 'R'eprograma...
+    char   que;     // tipus d'event (OBRIR, ARRIBADA...) o 0 si no aplica
+    char   res;     // reservat
+    int    res2;    // reservat (alineacio)
+}rtraca;
+
+// Capcalera del fitxer bolcat: els registres van del mes antic al mes nou
+typedef struct {
+    char magic[8];       // TRACAMAGIC
+    int  versio;         // TRACAVERSIO
+    int  mida;           // sizeof(rtraca)
+    long long n;         // registres al fitxer
+    long long perduts;   // registres sobreescrits pel buffer circular
+}ctraca;
+
+extern unsigned int traca_cats;  // categories actives
+
+// Nomes es crida la funcio si la categoria esta activa: cost gairebe nul si no
+#define TRACA(cat, t, op, que, on, lon, valor) \
+    do { if (traca_cats & (cat)) registra_traca((cat), (t), (op), (que), (on), (lon), (valor)); } while (0)
+
+void ini_traca(const char *cats);
+unsigned int parse_cats_traca(const char *cats);
+void registra_traca(int cat, double t, int op, int que, int on, int lon, float valor);
+int bolca_traca(const char *filename);
+void allibera_traca(void);
+
+#endif	/* TRACA_H */
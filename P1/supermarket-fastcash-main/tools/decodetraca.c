@@ -0,0 +1,97 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Eina per llegir el fitxer binari de traces bolcat pel simulador
+ * (bolca_traca) i escriure'l en text, un registre per línia.
+ *
+ * Use: decodetraca [fitxer] [categories]
+ * Example: decodetraca log/traca.bin serv,cua
+ *
+ * File:   decodetraca.c
+ * Author: Dolors Sala
+ */
+
+#include <string.h>
+#include "sev.h"
+
+FILE *ofile = NULL;
+
+// Nom de la categoria d'un registre
+static const char *nom_cat(int cat){
+    switch (cat){
+        case TRACAserv:     return ("serv");
+        case TRACAagenda:   return ("agenda");
+        case TRACAcua:      return ("cua");
+        case TRACAquinaCua: return ("quinaCua");
+        case TRACAalea:     return ("alea");
+        default:            return ("?");
+    }
+} // nom_cat
+
+// Escriu un registre en text segons la seva categoria
+static void imprimir_registre(rtraca *r){
+    char que = r->que ? r->que : '-';
+
+    printf("%.4lf %-8s ", r->t, nom_cat(r->cat));
+    switch (r->cat){
+        case TRACAagenda:
+            printf("%s AGENDA (%c, %8.4lf, %2d) long %d\n",
+                   r->op == 'P' ? "Posa" : r->op == 'T' ? "Treu" :
+                   r->op == 'C' ? "Cancela" : "Reprograma",
+                   que, r->valor, r->on, r->lon);
+            break;
+        case TRACAcua:
+            printf("%s CUA %d elem %7.4lf (long %d)\n",
+                   r->op == 'P' ? "POSA" : "TREU", r->on, r->valor, r->lon);
+            break;
+        case TRACAserv:
+            if (r->op == 'E')
+                printf("Cua %d TEMPS total d'espera a la cua %.4lf\n", r->on, r->valor);
+            else
+                printf("Cua %d (%c) TEMPS servei %.4lf SORTIDA %.4lf\n",
+                       r->on, que, r->valor, r->t + r->valor);
+            break;
+        case TRACAquinaCua:
+            if (r->op == 'B')
+                printf("Primer Caixer Buit %d (%s)\n", r->on, r->valor ? "rapid" : "lent");
+            else
+                printf("Cua mes curta %d long %d (%s)\n", r->on, r->lon, r->valor ? "rapid" : "lent");
+            break;
+        case TRACAalea:
+            printf("%s %lf utilitzat per %s cua %d\n", "Numero aleatori", r->valor,
+                   r->op == 'A' ? "la seguent arribada" : "el temps de servei", r->on);
+            break;
+        default:
+            printf("op %c que %c on %d lon %d valor %f\n", r->op, que, r->on, r->lon, r->valor);
+    }
+} // imprimir_registre
+
+int main(int argc, char **argv){
+    char *filename = TRACAFILENAME;
+    unsigned int cats = TRACAtot;
+    FILE *f;
+    ctraca c;
+    rtraca r;
+    long long i;
+
+    if (argc > 1) filename = argv[1];
+    if (argc > 2) cats = parse_cats_traca(argv[2]);
+    f = fopen(filename, "rb");
+    if (f == NULL){
+        fprintf(stderr, "ERROR decodetraca: no es pot obrir %s\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    if (fread(&c, sizeof(c), 1, f) != 1 || memcmp(c.magic, TRACAMAGIC, sizeof(c.magic))
+            || c.versio != TRACAVERSIO || c.mida != sizeof(rtraca)){
+        fprintf(stderr, "ERROR decodetraca: %s no es un fitxer de traces valid\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    printf("# %s: %lld registres (%lld anteriors sobreescrits)\n", filename, c.n, c.perduts);
+    for (i = 0; i < c.n && fread(&r, sizeof(r), 1, f) == 1; i++){
+        if (cats & r.cat)
+            imprimir_registre(&r);
+    }
+    fclose(f);
+    return (0);
+} // main
@@ -0,0 +1,211 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Monitor de la telemetria en viu d'una simulacio (sev -g segment, veure
+ * src/telemetria.h). Llegeix el segment de memoria compartida sense
+ * bloquejar el simulador (seqlock: si la lectura coincideix amb una
+ * escriptura es torna a fer) i cada interval escriu una linia amb el
+ * progres, els events per segon, els caixers ocupats, les cues i les
+ * esperes mitjanes fins ara, amb el canvi relatiu de l'espera respecte la
+ * linia anterior per veure'n la convergencia. Acaba quan la simulacio
+ * acaba o el seu proces desapareix.
+ *
+ * Use: supermon [-i ms] [-c] segment
+ *      -i ms  interval entre lectures (SMINTERVAL per defecte)
+ *      -c     escriu tambe la longitud de la cua de cada caixer
+ * Example: supermon -i 500 sev
+ *
+ * File:   supermon.c
+ * Author: Dolors Sala
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sev.h"
+#include "stats.h"
+#include "telemetria.h"
+
+#define SMINTERVAL   1000    // ms entre lectures per defecte
+
+// Temps actual en segons
+static double ara_s(void){
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return(ts.tv_sec + ts.tv_nsec / 1e9);
+} // ara_s
+
+// Espera ms milisegons
+static void dorm_ms(int ms){
+    struct timespec ts;
+
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long) (ms % 1000) * 1000000L;
+    nanosleep(&ts, NULL);
+} // dorm_ms
+
+// Projecta el segment nom (nomes lectura) i en deixa la mida a mida.
+// Retorna NULL si no existeix o no es un segment de telemetria.
+static const stelemetria *obre_segment(const char *nom, size_t *mida){
+    const stelemetria *t;
+    struct stat st;
+    void *p;
+    int fd;
+
+    fd = shm_open(nom, O_RDONLY, 0);
+    if(fd < 0)
+        return(NULL);
+    if(fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(stelemetria)){
+        close(fd);
+        return(NULL);
+    }
+    p = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(p == MAP_FAILED)
+        return(NULL);
+    t = (const stelemetria *) p;
+    if(memcmp(t->magic, TELEMAGIC, sizeof(t->magic)) != 0 || t->versio != TELEVERSIO
+            || (size_t) st.st_size != MIDA_TELEMETRIA(t->ntc)){
+        munmap(p, (size_t) st.st_size);
+        return(NULL);
+    }
+    *mida = (size_t) st.st_size;
+    return(t);
+} // obre_segment
+
+// 1 si el proces del simulador encara existeix
+static int viu(const stelemetria *t){
+    return(kill(t->pid, 0) == 0 || errno != ESRCH);
+} // viu
+
+// Copia una publicacio sencera del segment t a c (seqlock). Retorna el
+// numero de la publicacio, 0 si el simulador no ha publicat res encara i
+// -1 si ha desaparegut a mitja escriptura.
+static long long llegeix(const stelemetria *t, stelemetria *c, size_t mida){
+    unsigned long long s1, s2;
+
+    for(;;){
+        s1 = atomic_load_explicit(&((stelemetria *) t)->seq, memory_order_acquire);
+        if(!(s1 & 1)){
+            memcpy((char *) c + offsetof(stelemetria, acabat), (const char *) t + offsetof(stelemetria, acabat),
+                   mida - offsetof(stelemetria, acabat));
+            atomic_thread_fence(memory_order_acquire);
+            s2 = atomic_load_explicit(&((stelemetria *) t)->seq, memory_order_relaxed);
+            if(s1 == s2)
+                return((long long) (s1 / 2));
+        }
+        // El simulador esta escrivint: se li deixa acabar (pot no tenir
+        // cap nucli mentre el lector en gasta un esperant)
+        if(!viu(t))
+            return(-1);
+        dorm_ms(1);
+    }
+} // llegeix
+
+// Escriu una linia de l'estat c. anterior es l'espera de la linia anterior
+// i evs els events per segon.
+static void escriu(const stelemetria *c, double anterior, double evs, int per_caixer){
+    int i, total = 0, max = 0;
+
+    for(i = 0; i < c->ntc; i++){
+        total += c->lon_cua[i];
+        if(c->lon_cua[i] > max)
+            max = c->lon_cua[i];
+    }
+    printf("t %9.2f (%3.0f%%) events %10lld %9.0f ev/s  ocupats %4d/%-4d cua %5d (max %3d)"
+           "  atesos %8lld espera %8.3f (rapids %8.3f lents %8.3f) super %8.3f",
+           c->ta, 100 * c->ta / c->tancar, c->events, evs, c->ocupats, c->ntc, total, max,
+           c->atesos, c->espera, c->espera_rapids, c->espera_lents, c->temps_super);
+    if(anterior > 0)
+        printf("  canvi %+.2f%%", 100 * (c->espera - anterior) / anterior);
+    printf("\n");
+    if(per_caixer){
+        printf("  cues:");
+        for(i = 0; i < c->ntc; i++)
+            printf(" %d%s", c->lon_cua[i], (i == c->n_rapids - 1) ? " |" : "");
+        printf("\n");
+    }
+    fflush(stdout);
+} // escriu
+
+int main(int argc, char **argv){
+    const stelemetria *t = NULL;
+    stelemetria *c;
+    char *nom;
+    size_t mida = 0;
+    long long n, darrera = 0;
+    long long events = 0;
+    double anterior = 0, ara, abans;
+    int opt, interval = SMINTERVAL, per_caixer = 0, avisat = 0;
+
+    while((opt = getopt(argc, argv, "i:c")) != -1){
+        switch(opt){
+            case 'i': interval = atoi(optarg); break;
+            case 'c': per_caixer = 1; break;
+            default:
+                fprintf(stderr, "Use: %s [-i ms] [-c] segment\n", argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if(optind != argc - 1 || interval <= 0){
+        fprintf(stderr, "Use: %s [-i ms] [-c] segment\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    nom = (char *) malloc(strlen(argv[optind]) + 2);
+    if(nom == NULL)
+        exit(EXIT_FAILURE);
+    sprintf(nom, "%s%s", (argv[optind][0] == '/') ? "" : "/", argv[optind]);
+
+    // El simulador pot no haver començat encara
+    while((t = obre_segment(nom, &mida)) == NULL){
+        if(!avisat)
+            fprintf(stderr, "supermon: esperant el segment %s\n", nom);
+        avisat = 1;
+        dorm_ms(interval);
+    }
+    c = (stelemetria *) calloc(1, mida);
+    if(c == NULL)
+        exit(EXIT_FAILURE);
+    c->ntc = t->ntc;
+    c->n_rapids = t->n_rapids;
+    printf("Simulacio %d amb %d caixers (%d rapids), segment %s\n", t->pid, t->ntc, t->n_rapids, nom);
+
+    abans = ara_s();
+    for(;;){
+        n = llegeix(t, c, mida);
+        if(n < 0){
+            printf("El simulador (%d) ha acabat a mitja publicacio\n", t->pid);
+            break;
+        }
+        ara = ara_s();
+        if(n != darrera){
+            // els events per segon necessiten dues publicacions vistes
+            escriu(c, anterior, (darrera > 0) ? (c->events - events) / (ara - abans) : 0.0, per_caixer);
+            anterior = c->espera;
+            events = c->events;
+            darrera = n;
+            abans = ara;
+        }
+        if(c->acabat)
+            break;
+        if(!viu(t)){
+            printf("El simulador (%d) ha acabat sense publicar el final\n", t->pid);
+            break;
+        }
+        dorm_ms(interval);
+    }
+    munmap((void *) t, mida);
+    free(c);
+    free(nom);
+    return(0);
+} // main
@@ -26,6 +26,5 @@ int treu_agenda(float ta, esdev *e);
 void buida_agenda(void);
 void allibera_agenda(void);
 
-static esdev *agenda; // Llista d'events ordenats cronologicament
 #endif	/* AGENDA_H */
 
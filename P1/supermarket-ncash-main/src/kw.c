@@ -0,0 +1,225 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Motor rapid per al cas de ntc caixers amb una sola fila logica FCFS: el
+ * client que arriba va al primer caixer buit (com primer_caixer_buit) i, si
+ * no n'hi ha cap, espera el caixer que queda lliure abans. El temps de cua
+ * es calcula amb la recursio de Kiefer-Wolfowitz sobre el vector de
+ * treball pendent de cada caixer, sense agenda d'events ni cues:
+ *
+ *     W(n)   = max(0, min_c L(c) - T(n))      L(c): quan queda lliure c
+ *     L(c*) := T(n) + W(n) + S(n)             c*: el caixer del minim
+ *
+ * El vector es guarda com dos monticles petits: els caixers ocupats
+ * ordenats per (quan queden lliures, caixer) i els lliures ordenats per
+ * numero de caixer. Cada client costa O(log ntc).
+ *
+ * Omple els mateixos histogrames per caixer que el motor d'events (nca,
+ * dqhist, dshist i dthist) amb el mateix criteri: els clients atesos sense
+ * esperar nomes compten al temps de servei. La longitud de cua d'un caixer
+ * (qhist) son els clients de la fila que l'esperen a ell; com que se sap
+ * quan començara cada client, nomes cal guardar aquests instants.
+ *
+ * File:   kw.c
+ * Author: Dolors Sala
+ */
+
+#include "sev.h"
+#include "stats.h"
+#include "kw.h"
+
+// Caixer ocupat: instant en que queda lliure
+typedef struct {
+    double lliure;
+    int caixer;
+} socupat;
+
+// Clients que esperen un caixer: instants en que començaran el servei
+typedef struct {
+    double *inici;   // vector circular d'instants d'inici
+    int pri;         // primer client que espera
+    int lon;         // clients que esperen
+    int max;         // capacitat del vector (creix sota demanda)
+    double tq;       // fins aqui s'ha comptat a qhist
+} sespera;
+
+// Cert si el caixer a queda lliure abans que el b (empat: el de numero menor)
+static int abans(socupat *a, socupat *b){
+    if (a->lliure != b->lliure)
+        return (a->lliure < b->lliure);
+    return (a->caixer < b->caixer);
+} // abans
+
+// Posa el caixer o al monticle d'ocupats h de n elements
+static void posa_ocupat(socupat *h, int *n, socupat o){
+    int i, p;
+
+    i = (*n)++;
+    while (i > 0){
+        p = (i - 1) / 2;
+        if (!abans(&o, &h[p]))
+            break;
+        h[i] = h[p];
+        i = p;
+    }
+    h[i] = o;
+} // posa_ocupat
+
+// Treu el caixer que queda lliure abans del monticle d'ocupats h
+static socupat treu_ocupat(socupat *h, int *n){
+    socupat primer = h[0], ult;
+    int i, f;
+
+    ult = h[--(*n)];
+    i = 0;
+    while ((f = 2 * i + 1) < *n){
+        if (f + 1 < *n && abans(&h[f + 1], &h[f]))
+            f++;
+        if (!abans(&h[f], &ult))
+            break;
+        h[i] = h[f];
+        i = f;
+    }
+    h[i] = ult;
+    return (primer);
+} // treu_ocupat
+
+// Posa el caixer c al monticle de caixers lliures h de n elements
+static void posa_lliure(int *h, int *n, int c){
+    int i, p;
+
+    i = (*n)++;
+    while (i > 0 && h[p = (i - 1) / 2] > c){
+        h[i] = h[p];
+        i = p;
+    }
+    h[i] = c;
+} // posa_lliure
+
+// Treu el caixer lliure de numero mes petit del monticle h
+static int treu_lliure(int *h, int *n){
+    int primer = h[0], ult;
+    int i, f;
+
+    ult = h[--(*n)];
+    i = 0;
+    while ((f = 2 * i + 1) < *n){
+        if (f + 1 < *n && h[f + 1] < h[f])
+            f++;
+        if (h[f] >= ult)
+            break;
+        h[i] = h[f];
+        i = f;
+    }
+    h[i] = ult;
+    return (primer);
+} // treu_lliure
+
+// Compta a qhist[c] la longitud de la cua del caixer c fins a l'instant x:
+// els clients que comencen el servei abans de x deixen d'esperar
+static void avanca_espera(sespera *e, int c, double x, sstats *sts){
+    while (e->lon > 0 && e->inici[e->pri] <= x){
+        sts->qhist[c][e->lon] += (floor(e->inici[e->pri]) - floor(e->tq));
+        e->tq = e->inici[e->pri];
+        e->pri = (e->pri + 1) % e->max;
+        e->lon--;
+    }
+    sts->qhist[c][e->lon] += (floor(x) - floor(e->tq));
+    e->tq = x;
+} // avanca_espera
+
+// Afegeix al caixer c un client que començara el servei a l'instant st
+static void posa_espera(sespera *e, int c, double st){
+    double *nou;
+    int i;
+
+    if (e->lon + 1 >= MAXQUHIST)
+        ERROR((ofile, "ERROR: cua del caixer %d fora de rang %d a simula_kw\n", c, MAXQUHIST));
+    if (e->lon == e->max){   // dobla el vector circular i el deixa ordenat
+        nou = (double *) malloc(2 * e->max * sizeof(double));
+        if (nou == NULL)
+            ERROR((ofile, "ERROR: allocating memory in simula_kw\n"));
+        for (i = 0; i < e->lon; i++)
+            nou[i] = e->inici[(e->pri + i) % e->max];
+        free(e->inici);
+        e->inici = nou;
+        e->pri = 0;
+        e->max *= 2;
+    }
+    e->inici[(e->pri + e->lon) % e->max] = st;
+    e->lon++;
+} // posa_espera
+
+// Simula el supermercat amb ntc caixers i una sola fila FCFS i omple sts
+// (inicialitzat amb init_stats). Els clients que arriben abans de tancar
+// s'atenen tots.
+int simula_kw(int ntc, sstats *sts){
+    socupat *ocupats, o;
+    sespera *espera;
+    int *lliures;
+    int nocup, nlliu, c;
+    double t, w, s, tfi;
+
+    ocupats = (socupat *) malloc(ntc * sizeof(socupat));
+    lliures = (int *) malloc(ntc * sizeof(int));
+    espera = (sespera *) malloc(ntc * sizeof(sespera));
+    if (ocupats == NULL || lliures == NULL || espera == NULL)
+        ERROR((ofile, "ERROR: allocating memory in simula_kw\n"));
+    nocup = 0;
+    nlliu = 0;
+    for (c = 0; c < ntc; c++){
+        posa_lliure(lliures, &nlliu, c);
+        espera[c].max = CUA_MAX;
+        espera[c].inici = (double *) malloc(CUA_MAX * sizeof(double));
+        if (espera[c].inici == NULL)
+            ERROR((ofile, "ERROR: allocating memory in simula_kw\n"));
+        espera[c].pri = 0;
+        espera[c].lon = 0;
+        espera[c].tq = OBRIRTIME;
+    }
+    tfi = OBRIRTIME;
+
+    t = OBRIRTIME + expo(ARRIVAL);
+    while (t <= TANCARTIME){
+        // Els caixers que han acabat abans de l'arribada tornen a estar lliures
+        while (nocup > 0 && ocupats[0].lliure <= t){
+            o = treu_ocupat(ocupats, &nocup);
+            posa_lliure(lliures, &nlliu, o.caixer);
+        }
+        if (nlliu > 0){
+            c = treu_lliure(lliures, &nlliu);
+            w = 0.0;
+        }else{
+            o = treu_ocupat(ocupats, &nocup);
+            c = o.caixer;
+            w = o.lliure - t;
+        }
+        s = 1 + expo(SERVICE);
+        inc_stats(&sts->nca, c, NA, ntc, NA);
+        inc_stats(sts->dshist, c, (int)round(s), ntc, MAXDELHIST);
+        if (w > 0.0){
+            inc_stats(sts->dqhist, c, (int)round(w), ntc, MAXDELHIST);
+            inc_stats(sts->dthist, c, (int)round(w + s), ntc, MAXDELHIST);
+            avanca_espera(&espera[c], c, t, sts);
+            posa_espera(&espera[c], c, t + w);
+        }
+        o.lliure = t + w + s;
+        o.caixer = c;
+        posa_ocupat(ocupats, &nocup, o);
+        if (o.lliure > tfi)
+            tfi = o.lliure;
+
+        t += expo(ARRIVAL);
+    }
+
+    // Les cues es compten fins que surt l'ultim client
+    for (c = 0; c < ntc; c++){
+        avanca_espera(&espera[c], c, tfi, sts);
+        free(espera[c].inici);
+    }
+    free(espera);
+    free(ocupats);
+    free(lliures);
+    return (0);
+} // simula_kw
@@ -0,0 +1,18 @@
+/*
+ * Programa exemple del funcionament d'una simulacio orientada en events
+ * basada en el codi donat en el llibre Jorba, Capitol 2
+ *
+ * Declaracions del motor de Kiefer-Wolfowitz (cua unica FCFS sense agenda)
+ *
+ * File:   kw.h
+ * Author: Dolors Sala
+ */
+
+#ifndef KW_H
+#define	KW_H
+
+#include "stats.h"
+
+int simula_kw(int ntc, sstats *sts);
+
+#endif	/* KW_H */
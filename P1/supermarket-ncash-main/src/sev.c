@@ -18,8 +18,27 @@
 #include "./cua.h"
 #include "./agenda.h"
 #include "./stats.h"
+#include "./kw.h"
+#include <unistd.h>
 
-int main(void) {
+static int motor_kw = 0;   // 1: recursio de Kiefer-Wolfowitz en lloc de l'agenda
+
+// Llegeix les opcions de la linia de comandes:
+//   -k   motor de Kiefer-Wolfowitz (una sola fila FCFS, sense agenda)
+static void input_parameters(int argc, char **argv){
+    int opt;
+
+    while((opt = getopt(argc, argv, "k")) != -1){
+        switch(opt){
+            case 'k': motor_kw = 1; break;
+            default:
+                fprintf(stderr, "Use: %s [-k]\n", argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+} // input_parameters
+
+int main(int argc, char **argv) {
     esdev e;
     scua *cues = NULL; // vector dinamic de dimensio ntc
     el_cua c;
@@ -35,6 +54,8 @@ int main(void) {
     char *filename = OUTFILENAME;
     long int llavor = RANSEED;      //Inicialitzar generador numeros aleatoris
  
+    input_parameters(argc, argv);
+
     system("mkdir -p log");
     ofile = fopen(filename, "w");
     if(ofile == NULL){
@@ -57,6 +78,15 @@ int main(void) {
     
     print_configuracio(llavor, ntc);
     
+    if(motor_kw){
+        fprintf(ofile,"Motor Kiefer-Wolfowitz: una sola fila FCFS, sense agenda ni cues\n\n");
+        init_stats(&sts, ntc);
+        simula_kw(ntc, &sts);
+        collect_stats(sts, ntc);
+        free_stats(sts, ntc);
+        return (0);
+    }
+
     ini_agenda(N);
     crea_cues(&cues, CUA_MAX, ntc);
     init_stats(&sts, ntc);
@@ -27,7 +27,7 @@
 
 /******  Dimensions dels Vectors *********/
 #define CUA_MAX        10    // nombre maxim elements a la cua
-#define N              10     // Nombre maxim d'events pendents d'executar (a function of ntc)
+#define N              10     // Capacitat inicial de l'agenda d'events (creix sota demanda)
 
 #define MAXQUHIST      5000    // Dimension of the queueing histogram array stats
 #define MAXDELHIST     50000  // Dimension of the delay histogram array statistics